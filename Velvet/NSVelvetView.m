@@ -24,6 +24,15 @@
 #import <QuartzCore/QuartzCore.h>
 #import <objc/runtime.h>
 
+/*
+ * The last generation number assigned by any <NSVelvetView> to a pass of
+ * <[NSVelvetView recalculateNSViewClipping]>.
+ *
+ * This is global so that generations remain unique even when a <VELNSView>
+ * moves between `NSVelvetView` instances.
+ */
+static NSUInteger NSVelvetViewLastClippingGeneration = 0;
+
 static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, void *context) {
     VELNSView *hostA = viewA.hostView;
     VELNSView *hostB = viewB.hostView;
@@ -39,31 +48,9 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
         return NSOrderedDescending;
     }
 
-    VELView *ancestor = [hostA ancestorSharedWithView:(VELView *)hostB];
-    NSCAssert2(ancestor, @"Velvet-hosted NSViews in the same NSVelvetView should share a Velvet ancestor: %@, %@", viewA, viewB);
-
-    __block NSInteger orderA = -1;
-    __block NSInteger orderB = -1;
-
-    [ancestor.subviews enumerateObjectsUsingBlock:^(VELView *subview, NSUInteger index, BOOL *stop){
-        if ([hostA isDescendantOfView:subview]) {
-            orderA = (NSInteger)index;
-        } else if ([hostB isDescendantOfView:subview]) {
-            orderB = (NSInteger)index;
-        }
-
-        if (orderA >= 0 && orderB >= 0) {
-            *stop = YES;
-        }
-    }];
-
-    if (orderA < orderB) {
-        return NSOrderedAscending;
-    } else if (orderA > orderB) {
-        return NSOrderedDescending;
-    } else {
-        return NSOrderedSame;
-    }
+    // the paths share a prefix up to the common ancestor, after which the
+    // subview indices determine the order
+    return [hostA.treeOrderKey compare:hostB.treeOrderKey];
 }
 
 @interface NSVelvetView () {
@@ -72,6 +59,13 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
         BOOL userInteractionEnabled;
     } m_flags;
 
+    /*
+     * The generation of the last pass of <recalculateNSViewClipping>. Any
+     * <VELNSView> with a matching <[VELNSView clippingGeneration]> has
+     * up-to-date clipped bounds, which can be used for hit testing.
+     */
+    NSUInteger m_clippingGeneration;
+
     #ifdef DEBUG
     /**
      * An observer for `VELHostViewDebugModeChangedNotification`.
@@ -128,6 +122,25 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
  */
 @property (nonatomic, strong) NSCountedSet *velvetRegisteredDragTypes;
 
+/*
+ * The dragging destinations registered with the receiver, indexed by each of
+ * their supported UTIs.
+ *
+ * Each value in this dictionary is an `NSCountedSet` of the destinations which
+ * support the key type.
+ */
+@property (nonatomic, strong) NSMutableDictionary *draggingDestinationsByType;
+
+/*
+ * The registered dragging destinations which support any of the types on the
+ * pasteboard of the current dragging session.
+ *
+ * This is computed lazily by <deepestViewSupportingDraggingInfo:>, and reset
+ * whenever a dragging session begins or ends, or the set of registered
+ * destinations changes.
+ */
+@property (nonatomic, copy) NSSet *draggingSessionDestinations;
+
 /*
  * The tracking area used to enable mouse movement events within the Velvet
  * hierarchy.
@@ -188,6 +201,8 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 @synthesize trackingArea = m_trackingArea;
 @synthesize maskLayer = m_maskLayer;
 @synthesize velvetRegisteredDragTypes = m_velvetRegisteredDragTypes;
+@synthesize draggingDestinationsByType = m_draggingDestinationsByType;
+@synthesize draggingSessionDestinations = m_draggingSessionDestinations;
 
 - (void)setFocused:(BOOL)focused {
     m_focused = focused;
@@ -319,6 +334,7 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 
     // Set up to record dragging destinations
     self.allDraggingDestinations = [NSMutableSet set];
+    self.draggingDestinationsByType = [NSMutableDictionary dictionary];
 
     [self updateTrackingAreas];
 }
@@ -352,8 +368,15 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
     [self.appKitHostView.subviews enumerateObjectsWithOptions:NSEnumerationReverse usingBlock:^(NSView *view, NSUInteger index, BOOL *stop){
         id<VELBridgedView> hostView = view.hostView;
         if (hostView) {
-            CGRect bounds = hostView.layer.bounds;
-            CGRect clippedBounds = [hostView.layer convertAndClipRect:bounds toLayer:self.layer];
+            CGRect clippedBounds;
+
+            // use the rectangle from our clipping path, if it's up-to-date
+            VELNSView *NSViewHost = (id)hostView;
+            if ([NSViewHost isKindOfClass:[VELNSView class]] && NSViewHost.clippingGeneration == m_clippingGeneration) {
+                clippedBounds = NSViewHost.clippedBoundsInNSVelvetView;
+            } else {
+                clippedBounds = [hostView.layer convertAndClipRect:hostView.layer.bounds toLayer:self.layer];
+            }
 
             if (!CGRectContainsPoint(clippedBounds, point)) {
                 // skip this view
@@ -434,9 +457,44 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
     [self.appKitHostView sortSubviewsUsingFunction:&compareNSViewOrdering context:NULL];
 }
 
+- (void)recalculateNSViewOrderingForHostView:(VELNSView *)hostView; {
+    NSView *view = hostView.guestView;
+    if (view.superview != self.appKitHostView)
+        return;
+
+    // other views may be out of order too, and will all be sorted once
+    // they've moved
+    if ([VELView isRepositioningHostedNSViewsInBulk])
+        return;
+
+    // all other views are assumed to already be in order
+    NSMutableArray *subviews = [self.appKitHostView.subviews mutableCopy];
+    NSUInteger currentIndex = [subviews indexOfObjectIdenticalTo:view];
+    [subviews removeObjectAtIndex:currentIndex];
+
+    NSUInteger newIndex = [subviews
+        indexOfObject:view
+        inSortedRange:NSMakeRange(0, subviews.count)
+        options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+        usingComparator:^(NSView *viewA, NSView *viewB){
+            return compareNSViewOrdering(viewA, viewB, NULL);
+        }
+    ];
+
+    if (newIndex == currentIndex)
+        return;
+
+    [subviews insertObject:view atIndex:newIndex];
+
+    // this reorders the existing subviews without removing them
+    [self.appKitHostView setSubviews:subviews];
+}
+
 - (void)recalculateNSViewClipping; {
     CGMutablePathRef path = CGPathCreateMutable();
 
+    m_clippingGeneration = ++NSVelvetViewLastClippingGeneration;
+
     for (NSView *view in self.appKitHostView.subviews) {
         id<VELBridgedView> hostView = view.hostView;
         if (!hostView)
@@ -477,7 +535,17 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 
         // clip the frame of each NSView using the Velvet hierarchy
         CGRect rect = [hostView.layer convertAndClipRect:hostView.layer.visibleRect toLayer:self.layer];
-        if (CGRectIsNull(rect) || CGRectIsInfinite(rect))
+        if (CGRectIsInfinite(rect))
+            rect = CGRectNull;
+
+        // save the result for hit testing
+        if ([hostView isKindOfClass:[VELNSView class]]) {
+            VELNSView *NSViewHost = (id)hostView;
+            NSViewHost.clippedBoundsInNSVelvetView = rect;
+            NSViewHost.clippingGeneration = m_clippingGeneration;
+        }
+
+        if (CGRectIsNull(rect))
             continue;
 
         CGPathAddRect(path, NULL, rect);
@@ -547,7 +615,21 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
     if (!self.velvetRegisteredDragTypes)
         self.velvetRegisteredDragTypes = [[NSCountedSet alloc] init];
 
-    [self.velvetRegisteredDragTypes addObjectsFromArray:[destination supportedDragTypes]];
+    NSArray *types = [destination supportedDragTypes];
+    [self.velvetRegisteredDragTypes addObjectsFromArray:types];
+
+    for (NSString *type in types) {
+        NSCountedSet *destinations = [self.draggingDestinationsByType objectForKey:type];
+        if (!destinations) {
+            destinations = [[NSCountedSet alloc] init];
+            [self.draggingDestinationsByType setObject:destinations forKey:type];
+        }
+
+        [destinations addObject:destination];
+    }
+
+    // recompute the supported destinations if a drag is in progress
+    self.draggingSessionDestinations = nil;
 
     [self unregisterDraggedTypes];
     [self registerForDraggedTypes:[self.velvetRegisteredDragTypes allObjects]];
@@ -556,8 +638,17 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 - (void)unregisterDraggingDestination:(id<VELDraggingDestination>)destination; {
     for (NSString *type in [destination supportedDragTypes]) {
         [self.velvetRegisteredDragTypes removeObject:type];
+
+        NSCountedSet *destinations = [self.draggingDestinationsByType objectForKey:type];
+        [destinations removeObject:destination];
+
+        if (![destinations count])
+            [self.draggingDestinationsByType removeObjectForKey:type];
     }
 
+    // recompute the supported destinations if a drag is in progress
+    self.draggingSessionDestinations = nil;
+
     [self unregisterDraggedTypes];
 
     if ([self.velvetRegisteredDragTypes count]) {
@@ -568,28 +659,34 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 }
 
 - (VELView<VELDraggingDestination> *)deepestViewSupportingDraggingInfo:(id<NSDraggingInfo>)draggingInfo; {
+    NSSet *destinations = self.draggingSessionDestinations;
+    if (!destinations) {
+        // the pasteboard types don't change over the course of a drag, so only
+        // intersect them with the registered types once per session
+        NSMutableSet *supportingDestinations = [NSMutableSet set];
+
+        for (NSString *type in [[draggingInfo draggingPasteboard] types]) {
+            NSCountedSet *destinationsForType = [self.draggingDestinationsByType objectForKey:type];
+            if (destinationsForType)
+                [supportingDestinations unionSet:destinationsForType];
+        }
+
+        self.draggingSessionDestinations = supportingDestinations;
+        destinations = supportingDestinations;
+    }
+
+    if (![destinations count])
+        return nil;
+
     CGPoint draggedPoint = [self convertFromWindowPoint:[draggingInfo draggingLocation]];
-    NSArray *draggedTypes = [[draggingInfo draggingPasteboard] types];
 
     id view = [self descendantViewAtPoint:draggedPoint];
     if (![view isKindOfClass:[VELView class]])
         return nil;
 
-    BOOL (^viewSupportsDrag)(id) = ^(id testView){
-        if (![testView conformsToProtocol:@protocol(VELDraggingDestination)])
-            return NO;
-
-        for (NSString *supportedType in [testView supportedDragTypes]) {
-            if ([draggedTypes containsObject:supportedType])
-                return YES;
-        }
-
-        return NO;
-    };
-
     // find the first superview that supports drag-and-drop (or use this view if
     // it does)
-    while (!viewSupportsDrag(view)) {
+    while (![destinations containsObject:view]) {
         view = [view superview];
 
         if (!view)
@@ -601,6 +698,7 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 
 - (NSDragOperation)draggingEntered:(id<NSDraggingInfo>)sender {
     self.previousDraggingOperation = NSDragOperationNone;
+    self.draggingSessionDestinations = nil;
 
     id<VELDraggingDestination> view = [self deepestViewSupportingDraggingInfo:sender];
     self.lastDraggingDestination = view;
@@ -662,6 +760,7 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
     [self.allDraggingDestinations removeAllObjects];
     self.lastDraggingDestination = nil;
     self.previousDraggingOperation = NSDragOperationNone;
+    self.draggingSessionDestinations = nil;
 }
 
 - (void)draggingExited:(id<NSDraggingInfo>)sender {
@@ -672,6 +771,7 @@ static NSComparisonResult compareNSViewOrdering (NSView *viewA, NSView *viewB, v
 
     self.lastDraggingDestination = nil;
     self.previousDraggingOperation = NSDragOperationNone;
+    self.draggingSessionDestinations = nil;
 }
 
 - (BOOL)prepareForDragOperation:(id<NSDraggingInfo>)sender {
@@ -9,6 +9,8 @@
 #import <Velvet/NSVelvetView.h>
 #import <Velvet/VELDraggingDestination.h>
 
+@class VELNSView;
+
 /*
  * Private functionality of <NSVelvetView> that needs to be exposed to other parts of
  * the framework.
@@ -67,4 +69,19 @@
  * changed, and asks it to reorder its subviews to match Velvet.
  */
 - (void)recalculateNSViewOrdering;
+
+/*
+ * Informs the receiver that the position of the given <VELNSView> in the
+ * Velvet hierarchy has changed, and asks it to move the view's `NSView` to
+ * match.
+ *
+ * This is much cheaper than <recalculateNSViewOrdering> when only one view has
+ * moved, since the `NSView` can be repositioned with a binary search of the
+ * other views. When a subtree containing several <VELNSView>s moves, this
+ * does nothing, and the subtree's root invokes <recalculateNSViewOrdering>
+ * once they have all moved.
+ *
+ * @param hostView A <VELNSView> hosted in the receiver.
+ */
+- (void)recalculateNSViewOrderingForHostView:(VELNSView *)hostView;
 @end
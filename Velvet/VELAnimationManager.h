@@ -8,6 +8,9 @@
 
 #import <Foundation/Foundation.h>
 
+@class CALayer;
+@class VELCustomPropertyAnimation;
+
 /**
  * This private class is responsible for disabling implicit `NSView` animations.
  *
@@ -25,4 +28,173 @@
  */
 + (VELAnimationManager *)defaultManager;
 
+/*
+ * @name Disabling Implicit Animations
+ */
+
+/*
+ * Whether the duration of the current `NSAnimationContext` should be reset to
+ * zero after it has been changed by a <VELView> animation, disabling implicit
+ * `NSView` animations outside of animation blocks.
+ *
+ * The reset happens at the start of the next main run loop iteration. Run loop
+ * iterations in which no animation changed the duration are not observed at
+ * all.
+ *
+ * The default value is `YES`.
+ */
+@property (nonatomic, assign) BOOL resetsAnimationContextDuration;
+
+/*
+ * The number of main run loop iterations in which the duration of the
+ * `NSAnimationContext` was reset.
+ */
+@property (nonatomic, assign, readonly) NSUInteger touchedRunLoopIterationCount;
+
+/*
+ * Notifies the receiver that the duration of the current `NSAnimationContext`
+ * has been changed, so that it will be reset at the start of the next main run
+ * loop iteration.
+ *
+ * This must be called on the main thread.
+ */
+- (void)animationContextDurationDidChange;
+
+/*
+ * @name Preparing Animations
+ */
+
+/*
+ * Renders snapshots of the `NSView`s hosted by the given <VELNSView> instances
+ * during idle time on the main run loop, so that animations involving them
+ * don't need to render them synchronously.
+ *
+ * The views are processed a few at a time, whenever the main run loop is about
+ * to wait in its default mode, so that event handling and drawing are not
+ * delayed.
+ *
+ * @param views An array of <VELNSView> instances whose `NSView`s should be
+ * rendered.
+ * @param completionBlock A block to invoke on the main thread after all of
+ * the given views have been rendered. This may be `nil`.
+ */
+- (void)prepareSnapshotsOfViews:(NSArray *)views completion:(void (^)(void))completionBlock;
+
+/*
+ * @name Animating Custom Properties
+ */
+
+/*
+ * Begins running the given animation, replacing any existing animation of the
+ * same object and key.
+ *
+ * Animations are sampled on a display link's thread once per frame. The
+ * sampled values for every running animation are then applied together, in
+ * a single callback on the main thread.
+ *
+ * @param animation The animation to run.
+ */
+- (void)addCustomPropertyAnimation:(VELCustomPropertyAnimation *)animation;
+
+/*
+ * Stops any animation of the given property, leaving it at its current value,
+ * and invokes the completion block of the animation with `finished` set to
+ * `NO`.
+ *
+ * @param object The object whose property is being animated.
+ * @param key The key of the animated property, or `nil` to stop all
+ * animations of `object`.
+ */
+- (void)stopCustomPropertyAnimationsOfObject:(id)object forKey:(NSString *)key;
+
+/*
+ * @name Telemetry
+ */
+
+/*
+ * Whether statistics should be recorded about <VELView> animations.
+ *
+ * While this is enabled, every animation block records how long its
+ * animations took to define (excluding the commit of its transaction), how
+ * many layers it touched, and how many <VELNSView> snapshots were rendered
+ * for it. In addition, a display link records the
+ * interval between frames for as long as any recorded animation is in
+ * progress.
+ *
+ * Recorded data is kept until <resetTelemetry> is invoked, even after this
+ * property is set to `NO`.
+ *
+ * The default value is `NO`.
+ */
+@property (nonatomic, assign, getter = isRecordingTelemetry) BOOL recordingTelemetry;
+
+/*
+ * Returns all of the telemetry recorded so far.
+ *
+ * The returned dictionary contains two arrays:
+ *
+ *  - `animationBlocks`, which contains a dictionary for each animation block,
+ *  in the order that they finished. Each dictionary contains the
+ *  `beginTime` of the block, in seconds since recording started, its
+ *  `defineDuration` in seconds, its `nestingLevel` (zero for an outermost
+ *  block), and its `layerCount` and `snapshotCount`.
+ *  - `frameIntervals`, which contains the time between each pair of
+ *  consecutive frames displayed during animations, in seconds.
+ *
+ * The returned dictionary can be serialized with `NSJSONSerialization`.
+ */
+- (NSDictionary *)telemetry;
+
+/*
+ * Returns <telemetry> serialized as JSON.
+ */
+- (NSData *)telemetryJSONData;
+
+/*
+ * Discards all of the telemetry recorded so far.
+ */
+- (void)resetTelemetry;
+
+/*
+ * Begins a telemetry record for an animation block. This should be balanced
+ * with a call to <endTelemetryForAnimationBlock> once the animation block has
+ * run, before its transaction is committed.
+ *
+ * This does nothing unless <recordingTelemetry> is enabled.
+ *
+ * @return Whether a record was started.
+ */
+- (BOOL)beginTelemetryForAnimationBlock;
+
+/*
+ * Finishes the record started by the most recent call to
+ * <beginTelemetryForAnimationBlock>.
+ */
+- (void)endTelemetryForAnimationBlock;
+
+/*
+ * Notifies the receiver that an animation block for which a telemetry record
+ * was started has completed, so that frame intervals need not be recorded for
+ * it any longer.
+ */
+- (void)animationBlockForTelemetryDidComplete;
+
+/*
+ * Records that an action was requested for the given layer in the innermost
+ * animation block. Each layer is only counted once per block.
+ *
+ * This does nothing if no telemetry record is in progress.
+ *
+ * @param layer The layer being animated.
+ */
+- (void)recordTelemetryForLayer:(CALayer *)layer;
+
+/*
+ * Records that a <VELNSView> snapshot was rendered in the innermost animation
+ * block.
+ *
+ * This does nothing if no telemetry record is in progress.
+ */
+- (void)recordTelemetryForSnapshot;
+
 @end
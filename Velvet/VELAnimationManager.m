@@ -7,37 +7,245 @@
 //
 
 #import "VELAnimationManager.h"
+#import "VELCustomPropertyAnimation.h"
+#import "VELNSViewPrivate.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
 
 /**
- * Disables implicit AppKit animations on every run loop iteration.
+ * The longest that <[VELAnimationManager prepareSnapshotsOfViews:completion:]>
+ * should spend rendering snapshots during any one idle slice.
+ */
+static const CFTimeInterval VELAnimationManagerSnapshotSliceDuration = 0.004;
+
+/**
+ * Disables implicit AppKit animations at the start of a run loop iteration
+ * following a change to the `NSAnimationContext`.
  *
  * @param observer The run loop observer which triggered this callback.
  * @param activity The stage of the run loop in which this function is being
  * triggered.
  * @param info Unused.
  */
-static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info) {
-    [[NSAnimationContext currentContext] setDuration:0];
+static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info);
+
+/**
+ * Renders some pending snapshots whenever the main run loop is about to wait.
+ *
+ * @param observer The run loop observer which triggered this callback.
+ * @param activity The stage of the run loop in which this function is being
+ * triggered.
+ * @param info Unused.
+ */
+static void snapshotRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info);
+
+/**
+ * Samples all running custom property animations for the frame being prepared
+ * by a display link.
+ *
+ * @param displayLink The display link which triggered this callback.
+ * @param now The current time.
+ * @param outputTime The time at which the frame will be displayed.
+ * @param flagsIn Unused.
+ * @param flagsOut Unused.
+ * @param context The <VELAnimationManager> which owns the display link.
+ */
+static CVReturn displayLinkCallback (CVDisplayLinkRef displayLink, const CVTimeStamp *now, const CVTimeStamp *outputTime, CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *context);
+
+@interface VELAnimationManager () {
+    /**
+     * Guards <customPropertyAnimations> and <customPropertyDeliveryScheduled>,
+     * which are accessed from the display link's thread.
+     */
+    OSSpinLock m_customPropertyAnimationsLock;
+
+    /**
+     * Guards <telemetryFrameIntervals>, <telemetryAnimationsInFlight> and
+     * <lastTelemetryFrameTime>, which are accessed from the display link's
+     * thread.
+     */
+    OSSpinLock m_telemetryLock;
 }
 
-@interface VELAnimationManager ()
 /**
  * The observer associated with the main run loop, responsible for invoking the
- * <mainRunLoopObserverCallback>.
+ * <mainRunLoopObserverCallback>, or `NULL` if a reset of the
+ * `NSAnimationContext` is not currently armed.
  */
 @property (nonatomic) CFRunLoopObserverRef mainRunLoopObserver;
 
+/**
+ * Redeclared to be readwrite.
+ */
+@property (nonatomic, assign, readwrite) NSUInteger touchedRunLoopIterationCount;
+
+/**
+ * Resets the duration of the current `NSAnimationContext` to zero, and disarms
+ * the <mainRunLoopObserver>.
+ */
+- (void)resetAnimationContextDuration;
+
+/**
+ * The observer associated with the main run loop, responsible for invoking the
+ * <snapshotRunLoopObserverCallback> while there are snapshots left to render.
+ */
+@property (nonatomic) CFRunLoopObserverRef snapshotRunLoopObserver;
+
+/**
+ * The <VELNSView> instances which have yet to be snapshotted, in the order
+ * that they were enqueued.
+ */
+@property (nonatomic, strong) NSMutableArray *pendingSnapshotViews;
+
+/**
+ * The number of views removed from the front of <pendingSnapshotViews> and
+ * rendered since the queue was last empty.
+ */
+@property (nonatomic, assign) NSUInteger renderedSnapshotCount;
+
+/**
+ * For each call to <prepareSnapshotsOfViews:completion:> that has not yet
+ * completed, an `NSNumber` holding the value that <renderedSnapshotCount> will
+ * reach once all of the call's views have been rendered.
+ */
+@property (nonatomic, strong) NSMutableArray *pendingSnapshotBatchEnds;
+
+/**
+ * The completion blocks of the calls to <prepareSnapshotsOfViews:completion:>
+ * described by <pendingSnapshotBatchEnds>. Calls without a completion block are
+ * represented by `NSNull`.
+ */
+@property (nonatomic, strong) NSMutableArray *pendingSnapshotCompletionBlocks;
+
+/**
+ * Renders pending snapshots until <VELAnimationManagerSnapshotSliceDuration>
+ * has elapsed, then invokes any completion blocks that are now due.
+ */
+- (void)renderPendingSnapshots;
+
+/**
+ * The display link which drives custom property animations, or `NULL` if one
+ * has not been created yet.
+ */
+@property (nonatomic) CVDisplayLinkRef displayLink;
+
+/**
+ * The <VELCustomPropertyAnimation> instances currently running.
+ *
+ * This should only be accessed while holding
+ * `m_customPropertyAnimationsLock`.
+ */
+@property (nonatomic, strong) NSMutableArray *customPropertyAnimations;
+
+/**
+ * Whether a call to <deliverCustomPropertyValues> has been enqueued on the
+ * main thread, but has not yet run.
+ *
+ * This should only be accessed while holding
+ * `m_customPropertyAnimationsLock`.
+ */
+@property (nonatomic, assign) BOOL customPropertyDeliveryScheduled;
+
+/**
+ * Samples every running custom property animation at the given time, and
+ * schedules a call to <deliverCustomPropertyValues> if any values changed.
+ *
+ * This is invoked on the display link's thread.
+ *
+ * @param time The time of the frame being prepared, in the same timebase as
+ * `CACurrentMediaTime()`.
+ */
+- (void)sampleCustomPropertyAnimationsAtTime:(CFTimeInterval)time;
+
+/**
+ * Applies the values most recently sampled by
+ * <sampleCustomPropertyAnimationsAtTime:> to their objects, and finishes any
+ * animations that have completed.
+ *
+ * This is invoked on the main thread.
+ */
+- (void)deliverCustomPropertyValues;
+
+/**
+ * Creates the <displayLink> if necessary, and starts it if it isn't already
+ * running.
+ *
+ * Returns `NO` if the display link could not be created, such as when there
+ * are no active displays.
+ */
+- (BOOL)startDisplayLink;
+
+/**
+ * Stops the <displayLink> if there are no custom property animations running,
+ * and no recorded animations in progress.
+ */
+- (void)stopDisplayLinkIfIdle;
+
+/**
+ * The media time at which telemetry started being recorded, used as the
+ * reference point for the `beginTime` of each animation block.
+ */
+@property (nonatomic, assign) CFTimeInterval telemetryStartTime;
+
+/**
+ * The dictionaries describing each finished animation block, as described in
+ * <telemetry>.
+ */
+@property (nonatomic, strong) NSMutableArray *telemetryAnimationBlocks;
+
+/**
+ * A stack of mutable dictionaries for the animation blocks currently being
+ * recorded, with the innermost block last.
+ */
+@property (nonatomic, strong) NSMutableArray *openTelemetryRecords;
+
+/**
+ * A stack of `NSHashTable`s containing the layers touched by each block in
+ * <openTelemetryRecords>.
+ */
+@property (nonatomic, strong) NSMutableArray *openTelemetryLayers;
+
+/**
+ * The intervals between frames recorded so far, as `NSNumber`s.
+ *
+ * This should only be accessed while holding `m_telemetryLock`.
+ */
+@property (nonatomic, strong) NSMutableArray *telemetryFrameIntervals;
+
+/**
+ * The number of recorded animation blocks whose animations have not yet
+ * completed.
+ *
+ * This should only be accessed while holding `m_telemetryLock`.
+ */
+@property (nonatomic, assign) NSUInteger telemetryAnimationsInFlight;
+
+/**
+ * The time of the last frame recorded while animations were in flight, or zero
+ * if no frame has been recorded since <telemetryAnimationsInFlight> last
+ * became nonzero.
+ *
+ * This should only be accessed while holding `m_telemetryLock`.
+ */
+@property (nonatomic, assign) CFTimeInterval lastTelemetryFrameTime;
+
+/**
+ * Records the interval since the last frame, if any recorded animations are
+ * in progress.
+ *
+ * This is invoked on the display link's thread.
+ *
+ * @param time The time at which the display link fired for the frame, in the
+ * same timebase as `CACurrentMediaTime()`.
+ */
+- (void)recordTelemetryForFrameAtTime:(CFTimeInterval)time;
+
 /**
  * Invoked on the <[VELAnimationManager defaultManager]> when the application
  * has finished launching.
  */
 - (void)applicationDidFinishLaunchingNotification:(NSNotification *)notification;
 
-/**
- * Registers an observer on the main run loop which will invoke the
- * <mainRunLoopObserverCallback>.
- */
-- (void)registerRunLoopObserver;
 @end
 
 @implementation VELAnimationManager
@@ -45,6 +253,24 @@ static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoo
 #pragma mark Properties
 
 @synthesize mainRunLoopObserver = m_mainRunLoopObserver;
+@synthesize resetsAnimationContextDuration = m_resetsAnimationContextDuration;
+@synthesize touchedRunLoopIterationCount = m_touchedRunLoopIterationCount;
+@synthesize snapshotRunLoopObserver = m_snapshotRunLoopObserver;
+@synthesize pendingSnapshotViews = m_pendingSnapshotViews;
+@synthesize renderedSnapshotCount = m_renderedSnapshotCount;
+@synthesize pendingSnapshotBatchEnds = m_pendingSnapshotBatchEnds;
+@synthesize pendingSnapshotCompletionBlocks = m_pendingSnapshotCompletionBlocks;
+@synthesize displayLink = m_displayLink;
+@synthesize customPropertyAnimations = m_customPropertyAnimations;
+@synthesize customPropertyDeliveryScheduled = m_customPropertyDeliveryScheduled;
+@synthesize recordingTelemetry = m_recordingTelemetry;
+@synthesize telemetryStartTime = m_telemetryStartTime;
+@synthesize telemetryAnimationBlocks = m_telemetryAnimationBlocks;
+@synthesize openTelemetryRecords = m_openTelemetryRecords;
+@synthesize openTelemetryLayers = m_openTelemetryLayers;
+@synthesize telemetryFrameIntervals = m_telemetryFrameIntervals;
+@synthesize telemetryAnimationsInFlight = m_telemetryAnimationsInFlight;
+@synthesize lastTelemetryFrameTime = m_lastTelemetryFrameTime;
 
 - (void)setMainRunLoopObserver:(CFRunLoopObserverRef)observer {
     if (observer == m_mainRunLoopObserver)
@@ -61,6 +287,54 @@ static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoo
     m_mainRunLoopObserver = observer;
 }
 
+- (void)setResetsAnimationContextDuration:(BOOL)resets {
+    NSAssert([NSThread isMainThread], @"Animation behavior should only be changed on the main thread");
+
+    m_resetsAnimationContextDuration = resets;
+
+    if (!resets)
+        self.mainRunLoopObserver = NULL;
+}
+
+- (void)setRecordingTelemetry:(BOOL)recording {
+    NSAssert([NSThread isMainThread], @"Telemetry should only be configured on the main thread");
+
+    if (recording && !self.telemetryAnimationBlocks)
+        [self resetTelemetry];
+
+    m_recordingTelemetry = recording;
+}
+
+- (void)setSnapshotRunLoopObserver:(CFRunLoopObserverRef)observer {
+    if (observer == m_snapshotRunLoopObserver)
+        return;
+
+    if (m_snapshotRunLoopObserver) {
+        CFRunLoopRemoveObserver(CFRunLoopGetMain(), m_snapshotRunLoopObserver, kCFRunLoopDefaultMode);
+        CFRelease(m_snapshotRunLoopObserver);
+    }
+
+    if (observer)
+        CFRetain(observer);
+
+    m_snapshotRunLoopObserver = observer;
+}
+
+- (void)setDisplayLink:(CVDisplayLinkRef)displayLink {
+    if (displayLink == m_displayLink)
+        return;
+
+    if (m_displayLink) {
+        CVDisplayLinkStop(m_displayLink);
+        CVDisplayLinkRelease(m_displayLink);
+    }
+
+    if (displayLink)
+        CVDisplayLinkRetain(displayLink);
+
+    m_displayLink = displayLink;
+}
+
 #pragma mark Lifecycle
 
 + (void)load {
@@ -72,6 +346,15 @@ static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoo
     ];
 }
 
+- (id)init {
+    self = [super init];
+    if (!self)
+        return nil;
+
+    m_resetsAnimationContextDuration = YES;
+    return self;
+}
+
 + (VELAnimationManager *)defaultManager; {
     static id singleton = nil;
     static dispatch_once_t pred;
@@ -87,13 +370,403 @@ static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoo
     [[NSNotificationCenter defaultCenter] removeObserver:self];
 
     self.mainRunLoopObserver = NULL;
+    self.snapshotRunLoopObserver = NULL;
+    self.displayLink = NULL;
+}
+
+#pragma mark Preparing Animations
+
+- (void)prepareSnapshotsOfViews:(NSArray *)views completion:(void (^)(void))completionBlock; {
+    NSAssert([NSThread isMainThread], @"Snapshots should only be prepared on the main thread");
+
+    if (!self.pendingSnapshotViews) {
+        self.pendingSnapshotViews = [NSMutableArray array];
+        self.pendingSnapshotBatchEnds = [NSMutableArray array];
+        self.pendingSnapshotCompletionBlocks = [NSMutableArray array];
+        self.renderedSnapshotCount = 0;
+    }
+
+    // views are rendered from the front of the queue, so this batch is done
+    // once everything up to and including its last view has been rendered
+    [self.pendingSnapshotViews addObjectsFromArray:views];
+    NSUInteger batchEnd = self.renderedSnapshotCount + [self.pendingSnapshotViews count];
+
+    [self.pendingSnapshotBatchEnds addObject:[NSNumber numberWithUnsignedInteger:batchEnd]];
+    [self.pendingSnapshotCompletionBlocks addObject:(completionBlock ? [completionBlock copy] : [NSNull null])];
+
+    if (!self.snapshotRunLoopObserver) {
+        CFRunLoopObserverRef observer = CFRunLoopObserverCreate(
+            NULL,
+            kCFRunLoopBeforeWaiting,
+            YES,
+            0,
+            &snapshotRunLoopObserverCallback,
+            NULL
+        );
+
+        CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopDefaultMode);
+
+        self.snapshotRunLoopObserver = observer;
+        CFRelease(observer);
+    }
+
+    // make sure the run loop gets to our observer, even if it's already
+    // waiting
+    CFRunLoopWakeUp(CFRunLoopGetMain());
+}
+
+- (void)renderPendingSnapshots; {
+    CFAbsoluteTime deadline = CFAbsoluteTimeGetCurrent() + VELAnimationManagerSnapshotSliceDuration;
+
+    while ([self.pendingSnapshotViews count]) {
+        VELNSView *view = [self.pendingSnapshotViews objectAtIndex:0];
+
+        [self.pendingSnapshotViews removeObjectAtIndex:0];
+        ++self.renderedSnapshotCount;
+
+        [view prepareSnapshotOfGuestView];
+
+        if (CFAbsoluteTimeGetCurrent() >= deadline)
+            break;
+    }
+
+    NSUInteger renderedCount = self.renderedSnapshotCount;
+
+    while ([self.pendingSnapshotBatchEnds count]) {
+        if ([[self.pendingSnapshotBatchEnds objectAtIndex:0] unsignedIntegerValue] > renderedCount)
+            break;
+
+        id completionBlock = [self.pendingSnapshotCompletionBlocks objectAtIndex:0];
+
+        [self.pendingSnapshotBatchEnds removeObjectAtIndex:0];
+        [self.pendingSnapshotCompletionBlocks removeObjectAtIndex:0];
+
+        if (completionBlock != [NSNull null])
+            ((void (^)(void))completionBlock)();
+    }
+
+    if ([self.pendingSnapshotViews count] || [self.pendingSnapshotBatchEnds count]) {
+        // keep the run loop spinning until we're done
+        CFRunLoopWakeUp(CFRunLoopGetMain());
+    } else {
+        self.snapshotRunLoopObserver = NULL;
+        self.pendingSnapshotViews = nil;
+        self.pendingSnapshotBatchEnds = nil;
+        self.pendingSnapshotCompletionBlocks = nil;
+        self.renderedSnapshotCount = 0;
+    }
+}
+
+#pragma mark Animating Custom Properties
+
+- (void)addCustomPropertyAnimation:(VELCustomPropertyAnimation *)animation; {
+    NSParameterAssert(animation != nil);
+    NSAssert([NSThread isMainThread], @"Custom property animations should only be added on the main thread");
+
+    [self stopCustomPropertyAnimationsOfObject:animation.object forKey:animation.key];
+
+    OSSpinLockLock(&m_customPropertyAnimationsLock);
+
+    if (!self.customPropertyAnimations)
+        self.customPropertyAnimations = [NSMutableArray array];
+
+    [self.customPropertyAnimations addObject:animation];
+
+    OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+    if (![self startDisplayLink]) {
+        // nothing will drive the animation, so jump straight to the final
+        // value instead of leaving the property stuck
+        OSSpinLockLock(&m_customPropertyAnimationsLock);
+        [self.customPropertyAnimations removeObjectIdenticalTo:animation];
+        OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+        [animation.object setValue:[NSNumber numberWithDouble:animation.toValue] forKey:animation.key];
+
+        if (animation.completionBlock)
+            animation.completionBlock(NO);
+    }
+}
+
+- (void)stopCustomPropertyAnimationsOfObject:(id)object forKey:(NSString *)key; {
+    NSAssert([NSThread isMainThread], @"Custom property animations should only be stopped on the main thread");
+
+    NSMutableArray *stoppedAnimations = [NSMutableArray array];
+
+    OSSpinLockLock(&m_customPropertyAnimationsLock);
+
+    for (VELCustomPropertyAnimation *animation in self.customPropertyAnimations) {
+        if (animation.object != object)
+            continue;
+
+        if (key && ![animation.key isEqualToString:key])
+            continue;
+
+        [stoppedAnimations addObject:animation];
+    }
+
+    [self.customPropertyAnimations removeObjectsInArray:stoppedAnimations];
+
+    OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+    for (VELCustomPropertyAnimation *animation in stoppedAnimations) {
+        if (animation.completionBlock)
+            animation.completionBlock(NO);
+    }
+}
+
+- (void)sampleCustomPropertyAnimationsAtTime:(CFTimeInterval)time; {
+    BOOL scheduleDelivery = NO;
+
+    OSSpinLockLock(&m_customPropertyAnimationsLock);
+
+    for (VELCustomPropertyAnimation *animation in self.customPropertyAnimations) {
+        // finished animations are just waiting to be delivered
+        if (animation.finished)
+            continue;
+
+        BOOL finished = NO;
+        animation.sampledValue = [animation valueAtTime:time finished:&finished];
+        animation.hasSampledValue = YES;
+        animation.finished = finished;
+
+        scheduleDelivery = YES;
+    }
+
+    // if the main thread hasn't caught up with the last frame yet, the values
+    // we just sampled will be picked up by the delivery already enqueued
+    if (self.customPropertyDeliveryScheduled)
+        scheduleDelivery = NO;
+    else if (scheduleDelivery)
+        self.customPropertyDeliveryScheduled = YES;
+
+    OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+    if (scheduleDelivery) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self deliverCustomPropertyValues];
+        });
+    }
+}
+
+- (void)deliverCustomPropertyValues; {
+    NSMutableArray *animations = [NSMutableArray array];
+    NSMutableArray *values = [NSMutableArray array];
+    NSMutableArray *finishedAnimations = [NSMutableArray array];
+    BOOL animationsRemaining;
+
+    OSSpinLockLock(&m_customPropertyAnimationsLock);
+
+    for (VELCustomPropertyAnimation *animation in self.customPropertyAnimations) {
+        if (!animation.hasSampledValue)
+            continue;
+
+        [animations addObject:animation];
+        [values addObject:[NSNumber numberWithDouble:animation.sampledValue]];
+        animation.hasSampledValue = NO;
+
+        if (animation.finished)
+            [finishedAnimations addObject:animation];
+    }
+
+    [self.customPropertyAnimations removeObjectsInArray:finishedAnimations];
+    animationsRemaining = ([self.customPropertyAnimations count] > 0);
+
+    self.customPropertyDeliveryScheduled = NO;
+
+    OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+    [animations enumerateObjectsUsingBlock:^(VELCustomPropertyAnimation *animation, NSUInteger index, BOOL *stop){
+        [animation.object setValue:[values objectAtIndex:index] forKey:animation.key];
+    }];
+
+    for (VELCustomPropertyAnimation *animation in finishedAnimations) {
+        if (animation.completionBlock)
+            animation.completionBlock(YES);
+    }
+
+    // completion blocks may have started new animations, so this will check
+    // again before stopping the display link
+    if (!animationsRemaining)
+        [self stopDisplayLinkIfIdle];
+}
+
+#pragma mark Display Link
+
+- (BOOL)startDisplayLink; {
+    if (!self.displayLink) {
+        CVDisplayLinkRef displayLink = NULL;
+        if (CVDisplayLinkCreateWithActiveCGDisplays(&displayLink) != kCVReturnSuccess)
+            return NO;
+
+        CVDisplayLinkSetOutputCallback(displayLink, &displayLinkCallback, (__bridge void *)self);
+
+        self.displayLink = displayLink;
+        CVDisplayLinkRelease(displayLink);
+    }
+
+    if (!CVDisplayLinkIsRunning(self.displayLink))
+        CVDisplayLinkStart(self.displayLink);
+
+    return YES;
+}
+
+- (void)stopDisplayLinkIfIdle; {
+    if (!self.displayLink)
+        return;
+
+    OSSpinLockLock(&m_customPropertyAnimationsLock);
+    BOOL idle = ([self.customPropertyAnimations count] == 0);
+    OSSpinLockUnlock(&m_customPropertyAnimationsLock);
+
+    OSSpinLockLock(&m_telemetryLock);
+    idle = idle && (self.telemetryAnimationsInFlight == 0);
+    OSSpinLockUnlock(&m_telemetryLock);
+
+    if (idle)
+        CVDisplayLinkStop(self.displayLink);
+}
+
+#pragma mark Telemetry
+
+- (NSDictionary *)telemetry; {
+    OSSpinLockLock(&m_telemetryLock);
+    NSArray *frameIntervals = [self.telemetryFrameIntervals copy];
+    OSSpinLockUnlock(&m_telemetryLock);
+
+    // deep copy the records, so that they're immutable
+    NSMutableArray *animationBlocks = [NSMutableArray arrayWithCapacity:[self.telemetryAnimationBlocks count]];
+    for (NSDictionary *record in self.telemetryAnimationBlocks) {
+        [animationBlocks addObject:[record copy]];
+    }
+
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+        animationBlocks, @"animationBlocks",
+        frameIntervals ?: [NSArray array], @"frameIntervals",
+        nil
+    ];
+}
+
+- (NSData *)telemetryJSONData; {
+    NSError *error = nil;
+    NSData *data = [NSJSONSerialization dataWithJSONObject:self.telemetry options:NSJSONWritingPrettyPrinted error:&error];
+
+    NSAssert(data, @"Telemetry could not be serialized as JSON: %@", error);
+    return data;
+}
+
+- (void)resetTelemetry; {
+    NSAssert([NSThread isMainThread], @"Telemetry should only be reset on the main thread");
+
+    self.telemetryStartTime = CACurrentMediaTime();
+    self.telemetryAnimationBlocks = [NSMutableArray array];
+
+    OSSpinLockLock(&m_telemetryLock);
+    self.telemetryFrameIntervals = [NSMutableArray array];
+    OSSpinLockUnlock(&m_telemetryLock);
+}
+
+- (BOOL)beginTelemetryForAnimationBlock; {
+    if (!self.recordingTelemetry)
+        return NO;
+
+    if (!self.openTelemetryRecords) {
+        self.openTelemetryRecords = [NSMutableArray array];
+        self.openTelemetryLayers = [NSMutableArray array];
+    }
+
+    NSMutableDictionary *record = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+        [NSNumber numberWithDouble:CACurrentMediaTime()], @"beginTime",
+        [NSNumber numberWithUnsignedInteger:[self.openTelemetryRecords count]], @"nestingLevel",
+        [NSNumber numberWithUnsignedInteger:0], @"snapshotCount",
+        nil
+    ];
+
+    [self.openTelemetryRecords addObject:record];
+    [self.openTelemetryLayers addObject:[NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality]];
+
+    OSSpinLockLock(&m_telemetryLock);
+    ++self.telemetryAnimationsInFlight;
+    OSSpinLockUnlock(&m_telemetryLock);
+
+    [self startDisplayLink];
+    return YES;
+}
+
+- (void)endTelemetryForAnimationBlock; {
+    NSMutableDictionary *record = [self.openTelemetryRecords lastObject];
+    NSHashTable *layers = [self.openTelemetryLayers lastObject];
+
+    NSAssert(record, @"%@ called without a matching %@", NSStringFromSelector(_cmd), NSStringFromSelector(@selector(beginTelemetryForAnimationBlock)));
+
+    [self.openTelemetryRecords removeLastObject];
+    [self.openTelemetryLayers removeLastObject];
+
+    CFTimeInterval beginTime = [[record objectForKey:@"beginTime"] doubleValue];
+
+    [record setObject:[NSNumber numberWithDouble:CACurrentMediaTime() - beginTime] forKey:@"defineDuration"];
+    [record setObject:[NSNumber numberWithDouble:beginTime - self.telemetryStartTime] forKey:@"beginTime"];
+    [record setObject:[NSNumber numberWithUnsignedInteger:[layers count]] forKey:@"layerCount"];
+
+    // telemetry may have been reset while the block was running, so don't
+    // assume that this array exists
+    [self.telemetryAnimationBlocks addObject:record];
+}
+
+- (void)animationBlockForTelemetryDidComplete; {
+    BOOL animationsRemaining;
+
+    OSSpinLockLock(&m_telemetryLock);
+
+    NSAssert(self.telemetryAnimationsInFlight > 0, @"Recorded animation completed more times than it started");
+    animationsRemaining = (--self.telemetryAnimationsInFlight > 0);
+
+    // don't count the idle time before the next animation as a frame
+    if (!animationsRemaining)
+        self.lastTelemetryFrameTime = 0;
+
+    OSSpinLockUnlock(&m_telemetryLock);
+
+    if (!animationsRemaining)
+        [self stopDisplayLinkIfIdle];
+}
+
+- (void)recordTelemetryForLayer:(CALayer *)layer; {
+    [[self.openTelemetryLayers lastObject] addObject:layer];
+}
+
+- (void)recordTelemetryForSnapshot; {
+    NSMutableDictionary *record = [self.openTelemetryRecords lastObject];
+    if (!record)
+        return;
+
+    NSUInteger snapshotCount = [[record objectForKey:@"snapshotCount"] unsignedIntegerValue];
+    [record setObject:[NSNumber numberWithUnsignedInteger:snapshotCount + 1] forKey:@"snapshotCount"];
+}
+
+- (void)recordTelemetryForFrameAtTime:(CFTimeInterval)time; {
+    OSSpinLockLock(&m_telemetryLock);
+
+    if (self.telemetryAnimationsInFlight > 0) {
+        CFTimeInterval lastTime = self.lastTelemetryFrameTime;
+
+        if (lastTime > 0)
+            [self.telemetryFrameIntervals addObject:[NSNumber numberWithDouble:time - lastTime]];
+
+        self.lastTelemetryFrameTime = time;
+    }
+
+    OSSpinLockUnlock(&m_telemetryLock);
 }
 
-#pragma mark Run Loop Observer
+#pragma mark Disabling Implicit Animations
+
+- (void)animationContextDurationDidChange; {
+    NSAssert([NSThread isMainThread], @"The animation context should only be changed on the main thread");
+
+    if (!self.resetsAnimationContextDuration || self.mainRunLoopObserver)
+        return;
 
-- (void)registerRunLoopObserver; {
-    // set up an observer on the main run loop that can disable implicit
-    // animations
     CFRunLoopObserverRef observer = CFRunLoopObserverCreate(
         NULL,
         kCFRunLoopBeforeTimers,
@@ -109,11 +782,59 @@ static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoo
     CFRelease(observer);
 }
 
+- (void)resetAnimationContextDuration; {
+    [[NSAnimationContext currentContext] setDuration:0];
+
+    ++self.touchedRunLoopIterationCount;
+    self.mainRunLoopObserver = NULL;
+}
+
 #pragma mark Notifications
 
 - (void)applicationDidFinishLaunchingNotification:(NSNotification *)notification; {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:notification.name object:nil];
-    [self registerRunLoopObserver];
+
+    // the default duration is nonzero, so reset it once to start off
+    [self animationContextDurationDidChange];
 }
 
 @end
+
+static void mainRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info) {
+    [[VELAnimationManager defaultManager] resetAnimationContextDuration];
+}
+
+static void snapshotRunLoopObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info) {
+    [[VELAnimationManager defaultManager] renderPendingSnapshots];
+}
+
+static CVReturn displayLinkCallback (CVDisplayLinkRef displayLink, const CVTimeStamp *now, const CVTimeStamp *outputTime, CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *context) {
+    static mach_timebase_info_data_t timebase;
+    static dispatch_once_t pred;
+
+    dispatch_once(&pred, ^{
+        mach_timebase_info(&timebase);
+    });
+
+    // host times are in mach_absolute_time() units, which is also the basis
+    // of CACurrentMediaTime()
+    #define secondsFromHostTime(HOST_TIME) \
+        ((CFTimeInterval)(HOST_TIME) * timebase.numer / timebase.denom / NSEC_PER_SEC)
+
+    // outputTime is when the frame is predicted to be displayed, which always
+    // advances by whole refresh periods, so measure frame intervals using the
+    // time of this callback instead
+    CFTimeInterval callbackTime = secondsFromHostTime(now->hostTime);
+    CFTimeInterval displayTime = secondsFromHostTime(outputTime->hostTime);
+
+    #undef secondsFromHostTime
+
+    @autoreleasepool {
+        VELAnimationManager *manager = (__bridge VELAnimationManager *)context;
+
+        [manager recordTelemetryForFrameAtTime:callbackTime];
+        [manager sampleCustomPropertyAnimationsAtTime:displayTime];
+    }
+
+    return kCVReturnSuccess;
+}
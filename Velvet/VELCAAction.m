@@ -9,10 +9,43 @@
 #import "VELCAAction.h"
 #import "VELView.h"
 #import "VELNSViewPrivate.h"
+#import "VELKeyframeAction.h"
 #import "CATransaction+BlockAdditions.h"
 #import <objc/runtime.h>
+#import <pthread.h>
 
-@interface VELCAAction ()
+/*
+ * The maximum number of distinct key objects to remember in
+ * <VELCAActionInterceptedKeyCache>.
+ */
+static const CFIndex VELCAActionInterceptedKeyCacheLimit = 256;
+
+/*
+ * Maps key strings, by pointer, to `kCFBooleanTrue` or `kCFBooleanFalse`
+ * depending on whether <[VELCAAction interceptsActionForKey:]> returns `YES`
+ * for them.
+ *
+ * Core Animation reuses the same string objects for property keys, so after
+ * the first lookup, checking a key is just a pointer hash. The keys are
+ * retained, so their addresses cannot be reused by other strings.
+ *
+ * This should only be used from the main thread.
+ */
+static CFMutableDictionaryRef VELCAActionInterceptedKeyCache = NULL;
+
+/*
+ * The key under which the <[VELCAAction completionBatch]> for a transaction is
+ * stored, using `+[CATransaction setValue:forKey:]`.
+ */
+static NSString * const VELCAActionCompletionBatchKey = @"VELCAActionCompletionBatch";
+
+@interface VELCAAction () {
+    /*
+     * If the receiver is the <completionBatch> of a transaction, the number of
+     * animations it is the delegate of which have not yet stopped.
+     */
+    NSUInteger m_pendingAnimationCount;
+}
 /*
  * The action that this action is proxying, as specified at the time of
  * initialization.
@@ -25,6 +58,30 @@
  */
 @property (nonatomic, strong) NSResponder *originalFirstResponder;
 
+/*
+ * The action responsible for tracking the completion of all animations in the
+ * transaction that the receiver was run in, or `nil` if the receiver's
+ * animation could not be tracked.
+ *
+ * The first action run in a transaction becomes the completion batch for the
+ * transaction, and is set as the delegate of every animation added by the
+ * actions in that transaction. Once all of those animations have stopped, the
+ * batch runs its <completionBlocks> at once.
+ */
+@property (nonatomic, strong) VELCAAction *completionBatch;
+
+/*
+ * If the receiver is the <completionBatch> of a transaction, the blocks to run
+ * when all of its animations have stopped, in the order that they were added.
+ */
+@property (nonatomic, strong) NSMutableArray *completionBlocks;
+
+/*
+ * Returns the <completionBatch> for the current transaction, creating it if
+ * necessary.
+ */
++ (VELCAAction *)currentCompletionBatch;
+
 /*
  * Invoked whenever the geometry property `key` of `layer` has changed.
  */
@@ -62,6 +119,10 @@
  * Schedules the given block to execute when the animation represented by the
  * receiver completes.
  *
+ * If the animation's completion is being tracked by a <completionBatch>, the
+ * block will run along with those of every other action in the same
+ * transaction, once all of their animations have stopped.
+ *
  * @param block A block to be run when the animation completes.
  * @param layer The layer that the receiver is attached to.
  */
@@ -81,6 +142,8 @@
 
 @synthesize innerAction = m_innerAction;
 @synthesize originalFirstResponder = m_originalFirstResponder;
+@synthesize completionBatch = m_completionBatch;
+@synthesize completionBlocks = m_completionBlocks;
 
 #pragma mark Lifecycle
 
@@ -162,10 +225,62 @@
     }
 }
 
+#pragma mark Completion tracking
+
++ (VELCAAction *)currentCompletionBatch; {
+    VELCAAction *batch = [CATransaction valueForKey:VELCAActionCompletionBatchKey];
+    if (!batch) {
+        batch = [[self alloc] initWithAction:nil];
+        batch.completionBlocks = [NSMutableArray array];
+
+        [CATransaction setValue:batch forKey:VELCAActionCompletionBatchKey];
+    }
+
+    return batch;
+}
+
+- (void)animationDidStop:(CAAnimation *)animation finished:(BOOL)finished {
+    NSAssert(m_pendingAnimationCount > 0, @"%@ received more animationDidStop:finished: messages than animations it was tracking", self);
+
+    if (--m_pendingAnimationCount > 0)
+        return;
+
+    NSArray *blocks = [self.completionBlocks copy];
+    [self.completionBlocks removeAllObjects];
+
+    for (void (^block)(void) in blocks) {
+        block();
+    }
+}
+
 #pragma mark Action interception
 
 - (void)runActionForKey:(NSString *)key object:(id)anObject arguments:(NSDictionary *)dict {
-    [self.innerAction runActionForKey:key object:anObject arguments:dict];
+    id<CAAction> action = self.innerAction;
+
+    if ([(id)action isKindOfClass:[CAAnimation class]] && ![(id)action delegate]) {
+        // track the completion of this animation along with every other
+        // animation in the transaction
+        VELCAAction *batch = [[self class] currentCompletionBatch];
+
+        CAAnimation *animation = [(id)action copy];
+        animation.delegate = batch;
+
+        ++batch->m_pendingAnimationCount;
+        self.completionBatch = batch;
+
+        action = animation;
+    } else if ([(id)action isKindOfClass:[VELKeyframeAction class]] && ![(id)action delegate]) {
+        // keyframe actions build their animation when run, so have them
+        // attach the batch to it
+        VELCAAction *batch = [[self class] currentCompletionBatch];
+        [(VELKeyframeAction *)action setDelegate:batch];
+
+        ++batch->m_pendingAnimationCount;
+        self.completionBatch = batch;
+    }
+
+    [action runActionForKey:key object:anObject arguments:dict];
 
     CAAnimation *animation = [anObject animationForKey:key];
     if (!animation)
@@ -183,7 +298,30 @@
 }
 
 + (BOOL)interceptsActionForKey:(NSString *)key {
-    return [key isEqualToString:@"opacity"] || [self interceptsGeometryActionForKey:key];
+    if (!pthread_main_np())
+        return [key isEqualToString:@"opacity"] || [self interceptsGeometryActionForKey:key];
+
+    if (!VELCAActionInterceptedKeyCache) {
+        CFDictionaryKeyCallBacks keyCallbacks = kCFTypeDictionaryKeyCallBacks;
+
+        // compare keys by identity
+        keyCallbacks.equal = NULL;
+        keyCallbacks.hash = NULL;
+
+        VELCAActionInterceptedKeyCache = CFDictionaryCreateMutable(NULL, 0, &keyCallbacks, NULL);
+    }
+
+    CFBooleanRef intercepts = CFDictionaryGetValue(VELCAActionInterceptedKeyCache, (__bridge void *)key);
+    if (intercepts)
+        return intercepts == kCFBooleanTrue;
+
+    BOOL result = [key isEqualToString:@"opacity"] || [self interceptsGeometryActionForKey:key];
+
+    // don't grow without bound if keys are being created dynamically
+    if (key && CFDictionaryGetCount(VELCAActionInterceptedKeyCache) < VELCAActionInterceptedKeyCacheLimit)
+        CFDictionarySetValue(VELCAActionInterceptedKeyCache, (__bridge void *)key, result ? kCFBooleanTrue : kCFBooleanFalse);
+
+    return result;
 }
 
 #pragma mark Action handlers
@@ -234,6 +372,14 @@
     NSParameterAssert(block != nil);
     NSParameterAssert(layer != nil);
 
+    VELCAAction *batch = self.completionBatch;
+    if (batch) {
+        [batch.completionBlocks addObject:[block copy]];
+        return;
+    }
+
+    // we can't observe the end of the animation directly (because it's not
+    // a CAAnimation, or already has a delegate), so estimate it instead
     CFTimeInterval duration = [CATransaction animationDuration];
 
     if ([(id)self.innerAction isKindOfClass:[CAAnimation class]]) {
@@ -10,73 +10,80 @@
 
 typedef void (^VELControlActionBlock)(NSEvent *);
 
-@interface VELControl ()
 /*
- * All of the action handlers registered on the receiver.
- *
- * The keys in this dictionary will be the blocks, and the values will be
- * `NSNumber` objects that represent the event mask each block is registered
- * for.
+ * The number of distinct events that can be represented in
+ * a `VELControlEventMask`.
  */
-@property (nonatomic, strong, readonly) NSMutableDictionary *actions;
+#define VELControlEventCount (sizeof(VELControlEventMask) * 8)
+
+@interface VELControl () {
+    /*
+     * The action handlers registered on the receiver, indexed by the bit
+     * position of the event that they are registered for.
+     *
+     * Each entry is an immutable array (or `nil`, if nothing is registered for
+     * that event) which is replaced wholesale whenever actions are added or
+     * removed. This allows <sendActionsForControlEvents:event:> to enumerate
+     * a snapshot without copying anything, even if handlers modify the
+     * registered actions while being invoked.
+     */
+    __strong NSArray *m_actionsByEvent[VELControlEventCount];
+}
+
 @end
 
 @implementation VELControl
 
 #pragma mark Properties
 
-@synthesize actions = m_actions;
 @synthesize selected = m_selected;
 
-#pragma mark Lifecycle
-
-- (id)init {
-    self = [super init];
-    if (!self)
-        return nil;
-
-    m_actions = [[NSMutableDictionary alloc] init];
-    return self;
-}
-
 #pragma mark Event Dispatch
 
 - (id)addActionForControlEvents:(VELControlEventMask)eventMask usingBlock:(VELControlActionBlock)actionBlock; {
     id action = [actionBlock copy];
 
-    NSNumber *actionEvents = [self.actions objectForKey:action];
-    VELControlEventMask mask = (VELControlEventMask)[actionEvents unsignedIntegerValue];
+    for (NSUInteger bit = 0; bit < VELControlEventCount; ++bit) {
+        if (!(eventMask & (1U << bit)))
+            continue;
 
-    // if the action wasn't already in the dictionary, the original mask
-    // will be zero anyways
-    mask |= eventMask;
+        NSArray *existingActions = m_actionsByEvent[bit];
+        if (!existingActions) {
+            m_actionsByEvent[bit] = [NSArray arrayWithObject:action];
+        } else if ([existingActions indexOfObjectIdenticalTo:action] == NSNotFound) {
+            m_actionsByEvent[bit] = [existingActions arrayByAddingObject:action];
+        }
+    }
 
-    [self.actions setObject:[NSNumber numberWithUnsignedInteger:mask] forKey:action];
     return action;
 }
 
 - (void)removeAction:(id)action forControlEvents:(VELControlEventMask)eventMask; {
-    if (action) {
-        NSNumber *actionEvents = [self.actions objectForKey:action];
-        if (!actionEvents)
-            return;
-
-        VELControlEventMask newMask = [actionEvents unsignedIntegerValue] & (~eventMask);
-        if (newMask) {
-            [self.actions setObject:[NSNumber numberWithUnsignedInteger:newMask] forKey:action];
-        } else {
-            [self.actions removeObjectForKey:action];
-        }
-    } else {
-        if (eventMask == VELControlAllEvents) {
-            [self.actions removeAllObjects];
-            return;
+    for (NSUInteger bit = 0; bit < VELControlEventCount; ++bit) {
+        if (!(eventMask & (1U << bit)))
+            continue;
+
+        NSArray *existingActions = m_actionsByEvent[bit];
+        if (!existingActions)
+            continue;
+
+        if (!action) {
+            m_actionsByEvent[bit] = nil;
+            continue;
         }
 
-        [[self.actions copy] enumerateKeysAndObjectsUsingBlock:^(id action, NSNumber *actionEvents, BOOL *stop){
-            VELControlEventMask newMask = [actionEvents unsignedIntegerValue] & (~eventMask);
-            [self.actions setObject:[NSNumber numberWithUnsignedInteger:newMask] forKey:action];
-        }];
+        NSUInteger index = [existingActions indexOfObjectIdenticalTo:action];
+        if (index == NSNotFound)
+            continue;
+
+        if (existingActions.count == 1) {
+            m_actionsByEvent[bit] = nil;
+        } else {
+            NSMutableArray *newActions = [existingActions mutableCopy];
+            [newActions removeObjectAtIndex:index];
+
+            m_actionsByEvent[bit] = [newActions copy];
+        }
     }
 }
 
@@ -85,11 +92,31 @@ typedef void (^VELControlActionBlock)(NSEvent *);
 }
 
 - (void)sendActionsForControlEvents:(VELControlEventMask)eventMask event:(NSEvent *)event; {
-    // copy actions in case any handler wants to remove it
-    for (VELControlActionBlock action in [self.actions copy]) {
-        NSNumber *actionEvents = [self.actions objectForKey:action];
-        if ([actionEvents unsignedIntegerValue] & eventMask) {
-            action(event);
+    // hold onto the current snapshots, in case any handler adds or removes
+    // actions
+    __strong NSArray *snapshots[VELControlEventCount] = { nil };
+
+    for (NSUInteger bit = 0; bit < VELControlEventCount; ++bit) {
+        if (eventMask & (1U << bit))
+            snapshots[bit] = m_actionsByEvent[bit];
+    }
+
+    for (NSUInteger bit = 0; bit < VELControlEventCount; ++bit) {
+        for (VELControlActionBlock action in snapshots[bit]) {
+            // if an action is registered for multiple events in 'eventMask',
+            // only invoke it for the first one
+            BOOL alreadyInvoked = NO;
+
+            for (NSUInteger previousBit = 0; previousBit < bit; ++previousBit) {
+                NSArray *previousActions = snapshots[previousBit];
+                if (previousActions && [previousActions indexOfObjectIdenticalTo:action] != NSNotFound) {
+                    alreadyInvoked = YES;
+                    break;
+                }
+            }
+
+            if (!alreadyInvoked)
+                action(event);
         }
     }
 }
@@ -0,0 +1,110 @@
+//
+//  VELCustomPropertyAnimation.h
+//  Velvet
+//
+//  Created by agent on 19.10.26.
+//  Copyright (c) 2026 Bitswift. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+/*
+ * Describes the animation of a numeric property that is not backed by a
+ * `CALayer`, such as the value displayed by a label.
+ *
+ * Sampling the animation with <valueAtTime:> is thread-safe, so that it can be
+ * done on the display link's thread. Everything else should only be used from
+ * the main thread, or under the lock of the <VELAnimationManager> that owns the
+ * animation.
+ */
+@interface VELCustomPropertyAnimation : NSObject
+
+/*
+ * @name Initialization
+ */
+
+/*
+ * Initializes an animation of the given property, beginning now.
+ *
+ * This is the designated initializer.
+ *
+ * @param object The object whose property should be animated. This object is
+ * not retained.
+ * @param key The key of the property to animate. The property will be set
+ * using key-value coding, with `NSNumber` values.
+ * @param fromValue The value at the beginning of the animation.
+ * @param toValue The value at the end of the animation.
+ * @param duration The length of the animation.
+ * @param timingFunction The pacing of the animation, or `nil` to animate
+ * linearly.
+ * @param completionBlock A block to invoke on the main thread when the
+ * animation finishes or is stopped. This may be `nil`.
+ */
+- (id)initWithObject:(id)object key:(NSString *)key fromValue:(double)fromValue toValue:(double)toValue duration:(CFTimeInterval)duration timingFunction:(CAMediaTimingFunction *)timingFunction completion:(void (^)(BOOL finished))completionBlock;
+
+/*
+ * @name Animation Attributes
+ */
+
+/*
+ * The object whose property is animated, or `nil` if it has been deallocated.
+ */
+@property (nonatomic, weak, readonly) id object;
+
+/*
+ * The key of the animated property.
+ */
+@property (nonatomic, copy, readonly) NSString *key;
+
+/*
+ * The value at the end of the animation.
+ */
+@property (nonatomic, assign, readonly) double toValue;
+
+/*
+ * The media time at which the animation began.
+ */
+@property (nonatomic, assign, readonly) CFTimeInterval beginTime;
+
+/*
+ * The block to invoke when the animation finishes or is stopped.
+ */
+@property (nonatomic, copy, readonly) void (^completionBlock)(BOOL finished);
+
+/*
+ * @name Sampling
+ */
+
+/*
+ * Returns the value of the property at the given media time.
+ *
+ * This method is thread-safe.
+ *
+ * @param time A time in the same timebase as `CACurrentMediaTime()`.
+ * @param finished If not `NULL`, this is set to whether the animation has
+ * finished by `time`.
+ */
+- (double)valueAtTime:(CFTimeInterval)time finished:(BOOL *)finished;
+
+/*
+ * @name Delivery
+ */
+
+/*
+ * The most recently sampled value of the property, which has not yet been
+ * applied to the <object>.
+ */
+@property (nonatomic, assign) double sampledValue;
+
+/*
+ * Whether <sampledValue> has changed since it was last applied.
+ */
+@property (nonatomic, assign) BOOL hasSampledValue;
+
+/*
+ * Whether the animation has finished, as of the time of <sampledValue>.
+ */
+@property (nonatomic, assign, getter = isFinished) BOOL finished;
+
+@end
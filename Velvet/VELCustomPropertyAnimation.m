@@ -0,0 +1,167 @@
+//
+//  VELCustomPropertyAnimation.m
+//  Velvet
+//
+//  Created by agent on 19.10.26.
+//  Copyright (c) 2026 Bitswift. All rights reserved.
+//
+
+#import "VELCustomPropertyAnimation.h"
+
+/*
+ * Evaluates one dimension of a cubic Bézier curve from (0, 0) to (1, 1), with
+ * control points `p1` and `p2`, at parameter `t`.
+ */
+static double bezierValue (double t, double p1, double p2) {
+    double u = 1 - t;
+    return 3 * u * u * t * p1 + 3 * u * t * t * p2 + t * t * t;
+}
+
+/*
+ * Returns the derivative of <bezierValue> at parameter `t`.
+ */
+static double bezierDerivative (double t, double p1, double p2) {
+    double u = 1 - t;
+    return 3 * u * u * p1 + 6 * u * t * (p2 - p1) + 3 * t * t * (1 - p2);
+}
+
+@interface VELCustomPropertyAnimation () {
+    /*
+     * The control points of the timing function, or (0, 0) and (1, 1) for
+     * linear pacing. These are copied out of the `CAMediaTimingFunction` so
+     * that sampling doesn't need to message it from another thread.
+     */
+    double m_controlPoints[4];
+}
+
+/*
+ * The value at the beginning of the animation.
+ */
+@property (nonatomic, assign, readonly) double fromValue;
+
+/*
+ * The length of the animation.
+ */
+@property (nonatomic, assign, readonly) CFTimeInterval duration;
+
+/*
+ * Returns the progress of the animation after `fraction` of its duration has
+ * elapsed, according to its timing function.
+ */
+- (double)progressForFraction:(double)fraction;
+@end
+
+@implementation VELCustomPropertyAnimation
+
+#pragma mark Properties
+
+@synthesize object = m_object;
+@synthesize key = m_key;
+@synthesize beginTime = m_beginTime;
+@synthesize completionBlock = m_completionBlock;
+@synthesize fromValue = m_fromValue;
+@synthesize toValue = m_toValue;
+@synthesize duration = m_duration;
+@synthesize sampledValue = m_sampledValue;
+@synthesize hasSampledValue = m_hasSampledValue;
+@synthesize finished = m_finished;
+
+#pragma mark Lifecycle
+
+- (id)initWithObject:(id)object key:(NSString *)key fromValue:(double)fromValue toValue:(double)toValue duration:(CFTimeInterval)duration timingFunction:(CAMediaTimingFunction *)timingFunction completion:(void (^)(BOOL finished))completionBlock; {
+    NSParameterAssert(object != nil);
+    NSParameterAssert(key != nil);
+
+    self = [super init];
+    if (!self)
+        return nil;
+
+    m_object = object;
+    m_key = [key copy];
+    m_fromValue = fromValue;
+    m_toValue = toValue;
+    m_duration = MAX(0, duration);
+    m_completionBlock = [completionBlock copy];
+    m_beginTime = CACurrentMediaTime();
+
+    m_controlPoints[0] = 0;
+    m_controlPoints[1] = 0;
+    m_controlPoints[2] = 1;
+    m_controlPoints[3] = 1;
+
+    if (timingFunction) {
+        float point[2];
+
+        [timingFunction getControlPointAtIndex:1 values:point];
+        m_controlPoints[0] = point[0];
+        m_controlPoints[1] = point[1];
+
+        [timingFunction getControlPointAtIndex:2 values:point];
+        m_controlPoints[2] = point[0];
+        m_controlPoints[3] = point[1];
+    }
+
+    return self;
+}
+
+#pragma mark Sampling
+
+- (double)progressForFraction:(double)fraction; {
+    double x1 = m_controlPoints[0];
+    double y1 = m_controlPoints[1];
+    double x2 = m_controlPoints[2];
+    double y2 = m_controlPoints[3];
+
+    // find the curve parameter for this fraction of the duration, using
+    // Newton's method, then bisection if that doesn't converge
+    double t = fraction;
+
+    for (int i = 0; i < 8; ++i) {
+        double error = bezierValue(t, x1, x2) - fraction;
+        if (fabs(error) < 1e-6)
+            return bezierValue(t, y1, y2);
+
+        double derivative = bezierDerivative(t, x1, x2);
+        if (fabs(derivative) < 1e-6)
+            break;
+
+        t -= error / derivative;
+        if (t < 0 || t > 1)
+            break;
+    }
+
+    double lower = 0;
+    double upper = 1;
+    t = fraction;
+
+    while (upper - lower > 1e-6) {
+        double x = bezierValue(t, x1, x2);
+        if (x < fraction)
+            lower = t;
+        else
+            upper = t;
+
+        t = (lower + upper) / 2;
+    }
+
+    return bezierValue(t, y1, y2);
+}
+
+- (double)valueAtTime:(CFTimeInterval)time finished:(BOOL *)finished; {
+    double fraction = 1;
+    if (self.duration > 0)
+        fraction = (time - self.beginTime) / self.duration;
+
+    if (finished)
+        *finished = (fraction >= 1);
+
+    if (fraction >= 1)
+        return self.toValue;
+    else if (fraction <= 0)
+        return self.fromValue;
+
+    double progress = [self progressForFraction:fraction];
+    return self.fromValue + (self.toValue - self.fromValue) * progress;
+}
+
+@end
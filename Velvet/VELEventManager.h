@@ -8,6 +8,68 @@
 
 #import <AppKit/AppKit.h>
 
+/*
+ * Keys for the dispatch phases recorded by <[VELEventManager
+ * eventDispatchTimings]>.
+ */
+
+/*
+ * Time spent hit testing to find the view for an event.
+ */
+extern NSString * const VELEventDispatchPhaseHitTest;
+
+/*
+ * Time spent collecting the event recognizers attached to the view hierarchy.
+ */
+extern NSString * const VELEventDispatchPhaseRecognizerCollection;
+
+/*
+ * Time spent asking event recognizers whether they prevent each other.
+ */
+extern NSString * const VELEventDispatchPhasePreventionChecks;
+
+/*
+ * Time spent in `-[VELEventRecognizer handleEvent:]`.
+ */
+extern NSString * const VELEventDispatchPhaseRecognizerHandling;
+
+/*
+ * Time spent dispatching the event to a view's responder methods.
+ */
+extern NSString * const VELEventDispatchPhaseViewDispatch;
+
+/*
+ * Total time spent by Velvet on the event, from the moment it was received by
+ * the event monitor.
+ */
+extern NSString * const VELEventDispatchPhaseTotal;
+
+/*
+ * Keys for the dictionary describing each phase in <[VELEventManager
+ * eventDispatchTimings]>.
+ */
+
+/*
+ * An `NSNumber` containing the number of events for which the phase was
+ * recorded.
+ */
+extern NSString * const VELEventDispatchTimingCountKey;
+
+/*
+ * An `NSNumber` containing the total time spent in the phase, in microseconds.
+ */
+extern NSString * const VELEventDispatchTimingTotalMicrosecondsKey;
+
+/*
+ * An `NSArray` of `NSNumber` event counts, forming a histogram of the time
+ * spent in the phase for each event. The first bucket counts events that took
+ * less than one microsecond. Each bucket after that covers twice the duration
+ * of the previous one, such that bucket `i` counts events that took at least
+ * `2^(i - 1)` microseconds, and less than `2^i` microseconds. The last bucket
+ * also includes any longer durations.
+ */
+extern NSString * const VELEventDispatchTimingHistogramKey;
+
 /*
  * Responsible for intercepting events and dispatching them to Velvet when
  * appropriate.
@@ -22,4 +84,105 @@
  * Returns the singleton instance of this class.
  */
 + (VELEventManager *)defaultManager;
+
+/*
+ * @name Event Coalescing
+ */
+
+/*
+ * Whether consecutive mouse drag and scroll wheel events should be merged
+ * before being dispatched.
+ *
+ * When this is enabled, a run of drag or scroll events of the same type, which
+ * would be delivered to the same responder, is held until the end of the
+ * current run loop iteration (or until an event of any other kind arrives).
+ * The events are then dispatched as one event, with the deltas of all of them
+ * summed, and the location and timestamp of the latest.
+ *
+ * This reduces the amount of work done for each event when the main thread
+ * falls behind. It should not be enabled if any views rely on receiving every
+ * intermediate event.
+ *
+ * Magnification events are never coalesced, since they cannot be synthesized.
+ *
+ * The default value for this property is `NO`.
+ */
+@property (nonatomic, assign) BOOL coalescesContinuousEvents;
+
+/*
+ * @name Instrumentation
+ */
+
+/*
+ * Whether to measure how long Velvet spends dispatching each event, and
+ * collect the results into <eventDispatchTimings>.
+ *
+ * The measurements are cheap, but not free, so this should only be enabled when
+ * the results will be used.
+ *
+ * Only fully dispatched events are recorded. Events merged by
+ * <coalescesContinuousEvents> are recorded once, when the merged event is
+ * dispatched, and events absorbed by an event recognizer are not recorded.
+ *
+ * The default value for this property is `NO`.
+ */
+@property (nonatomic, assign) BOOL recordsEventDispatchTimings;
+
+/*
+ * Returns the event dispatch timings recorded while
+ * <recordsEventDispatchTimings> was enabled.
+ *
+ * The returned dictionary is keyed by event type, as an `NSNumber`. Each value
+ * is a dictionary keyed by one of the `VELEventDispatchPhase` constants, and
+ * describes that phase using the `VELEventDispatchTiming` keys. Phases which
+ * never occurred for a given event type are omitted.
+ *
+ * This method may be invoked from any thread. The recorded counters are
+ * updated atomically, without locking, so the result may reflect events still
+ * being recorded.
+ */
+- (NSDictionary *)eventDispatchTimings;
+
+/*
+ * Discards all recorded event dispatch timings.
+ *
+ * This should only be invoked from the main thread.
+ */
+- (void)resetEventDispatchTimings;
+
+/*
+ * Writes the result of <eventDispatchTimings> to the given URL as a property
+ * list, with event types converted to strings. Returns whether the write was
+ * successful.
+ *
+ * @param URL The file URL to write to.
+ * @param error If not `NULL`, and an error occurs, this is set to an error
+ * describing the failure.
+ */
+- (BOOL)writeEventDispatchTimingsToURL:(NSURL *)URL error:(NSError **)error;
+
+/*
+ * @name Delayed Events
+ */
+
+/*
+ * Replays events previously delayed by an event recognizer, directly
+ * dispatching each one to the view that would have originally received it.
+ *
+ * The events are queued, and delivered in order. If the receiver is currently
+ * dispatching an event to event recognizers, the replayed events are delivered
+ * once that finishes, but before the current event reaches any views.
+ * Otherwise, they are delivered immediately.
+ *
+ * Events without a Velvet target (represented by `NSNull`), and events which
+ * AppKit would normally deliver even to a Velvet view (such as key events), are
+ * handed back to AppKit using `-[NSApplication sendEvent:]`, without going
+ * through Velvet again.
+ *
+ * @param events The `NSEvent` objects to replay.
+ * @param targets The view that each event in `events` should be delivered to,
+ * or `NSNull` if there is no such view. This array must have the same number of
+ * objects as `events`.
+ */
+- (void)replayDelayedEvents:(NSArray *)events targets:(NSArray *)targets;
 @end
@@ -17,6 +17,22 @@
 #import "VELKeyPress.h"
 #import "VELKeyPressEventRecognizer.h"
 #import "VELView.h"
+#import "VELViewController.h"
+#import "VELViewPrivate.h"
+#import <libkern/OSAtomic.h>
+#import <mach/mach_time.h>
+#import <objc/runtime.h>
+
+NSString * const VELEventDispatchPhaseHitTest = @"VELEventDispatchPhaseHitTest";
+NSString * const VELEventDispatchPhaseRecognizerCollection = @"VELEventDispatchPhaseRecognizerCollection";
+NSString * const VELEventDispatchPhasePreventionChecks = @"VELEventDispatchPhasePreventionChecks";
+NSString * const VELEventDispatchPhaseRecognizerHandling = @"VELEventDispatchPhaseRecognizerHandling";
+NSString * const VELEventDispatchPhaseViewDispatch = @"VELEventDispatchPhaseViewDispatch";
+NSString * const VELEventDispatchPhaseTotal = @"VELEventDispatchPhaseTotal";
+
+NSString * const VELEventDispatchTimingCountKey = @"VELEventDispatchTimingCount";
+NSString * const VELEventDispatchTimingTotalMicrosecondsKey = @"VELEventDispatchTimingTotalMicroseconds";
+NSString * const VELEventDispatchTimingHistogramKey = @"VELEventDispatchTimingHistogram";
 
 /**
  * An event mask for all mouse button or movement events.
@@ -31,10 +47,592 @@ static const NSUInteger VELMouseEventMask =
 
 /**
  * If this many seconds have passed since the timestamp of a mouse event in
- * <[VELEventManager mouseEventsToDeduplicate]>, remove the event.
+ * the deduplication buffer of <VELEventManager>, remove the event.
  */
 static const NSTimeInterval VELMouseEventDeduplicationStalenessInterval = 1;
 
+/**
+ * The maximum number of mouse events remembered for deduplication. If more
+ * events than this arrive within <VELMouseEventDeduplicationStalenessInterval>,
+ * the oldest ones are forgotten early.
+ */
+#define VELMouseEventDeduplicationCapacity 128
+
+/**
+ * The number of hash buckets that mouse event fingerprints are chained into,
+ * according to their type, button and window. This must be a power of two.
+ */
+#define VELMouseEventDeduplicationBucketCount 32
+
+/**
+ * Two mouse events with timestamps closer together than this many seconds may
+ * be considered duplicates.
+ */
+static const NSTimeInterval VELMouseEventDeduplicationTimestampTolerance = 0.1;
+
+/**
+ * Mouse event locations are stored in fingerprints as integers, in units of
+ * `1 / VELMouseEventFingerprintLocationScale` points.
+ */
+static const CGFloat VELMouseEventFingerprintLocationScale = 100;
+
+/**
+ * While the mouse remains inside the cached tracking rectangle of the last
+ * mouse tracking responder, a full hit test is skipped for at most this many
+ * consecutive mouse tracking events, to catch any geometry changes underneath
+ * the mouse.
+ *
+ * Changes to the view hierarchy always force a full hit test.
+ */
+static const NSUInteger VELMouseTrackingMaximumSkippedHitTests = 8;
+
+/**
+ * The original implementation of `-[NSWindow orderWindow:relativeTo:]`, which
+ * is replaced to keep the window lookup index of <VELEventManager> up-to-date.
+ */
+static void (*originalOrderWindowIMP)(id, SEL, NSWindowOrderingMode, NSInteger) = NULL;
+
+/**
+ * Incremented every time any window is ordered with `-[NSWindow
+ * orderWindow:relativeTo:]`.
+ */
+static NSUInteger VELWindowOrderingGeneration = 0;
+
+/**
+ * A compact description of a mouse event, containing just enough information
+ * to determine whether two events are duplicates.
+ */
+typedef struct {
+    /**
+     * The type of the event, or zero if this fingerprint has already been
+     * matched and should be ignored.
+     */
+    NSEventType type;
+
+    /**
+     * The button number of the event.
+     */
+    NSInteger buttonNumber;
+
+    /**
+     * The number of the window that the event occurred in.
+     */
+    NSInteger windowNumber;
+
+    /**
+     * The location of the event in its window, quantized using
+     * <VELMouseEventFingerprintLocationScale>.
+     */
+    long x, y;
+
+    /**
+     * The timestamp of the event.
+     */
+    NSTimeInterval timestamp;
+
+    /**
+     * The sequence number of the next older fingerprint in the same bucket, or
+     * `NSNotFound` if there is none.
+     */
+    NSUInteger previousInBucket;
+} VELMouseEventFingerprint;
+
+/**
+ * The phases of event dispatch that are timed when <[VELEventManager
+ * recordsEventDispatchTimings]> is enabled.
+ */
+typedef enum {
+    VELEventTimingPhaseHitTest,
+    VELEventTimingPhaseRecognizerCollection,
+    VELEventTimingPhasePreventionChecks,
+    VELEventTimingPhaseRecognizerHandling,
+    VELEventTimingPhaseViewDispatch,
+    VELEventTimingPhaseTotal,
+
+    VELEventTimingPhaseCount
+} VELEventTimingPhase;
+
+/**
+ * Timings are recorded separately for each event type less than this value.
+ * Any event types beyond this are not recorded.
+ */
+#define VELEventTimingEventTypeCount 64
+
+/**
+ * The number of buckets in each <VELEventTimingHistogram>.
+ */
+#define VELEventTimingBucketCount 24
+
+/**
+ * A histogram of the durations of one phase of event dispatch.
+ *
+ * All fields are updated atomically.
+ */
+typedef struct {
+    /**
+     * The number of durations recorded.
+     */
+    volatile int64_t count;
+
+    /**
+     * The sum of all the recorded durations, in nanoseconds.
+     */
+    volatile int64_t totalNanoseconds;
+
+    /**
+     * The number of durations that fell into each bucket, as described for
+     * `VELEventDispatchTimingHistogramKey`.
+     */
+    volatile int64_t buckets[VELEventTimingBucketCount];
+} VELEventTimingHistogram;
+
+/**
+ * The recorded histograms, by event type and phase.
+ */
+static VELEventTimingHistogram VELEventTimingHistograms[VELEventTimingEventTypeCount][VELEventTimingPhaseCount];
+
+/**
+ * Whether <[VELEventManager recordsEventDispatchTimings]> is enabled.
+ */
+static BOOL VELEventTimingEnabled = NO;
+
+/**
+ * The number of nested <beginEventTiming> calls which have not yet been
+ * balanced by <finishEventTiming>. Phases are only timed while this is
+ * nonzero.
+ */
+static NSUInteger VELEventTimingDepth = 0;
+
+/**
+ * The time spent in each phase so far for the event being timed, in
+ * `mach_absolute_time()` units.
+ */
+static uint64_t VELEventTimingCurrentDurations[VELEventTimingPhaseCount];
+
+/**
+ * A bitmask of the phases which have occurred for the event being timed.
+ */
+static uint32_t VELEventTimingCurrentPhases = 0;
+
+/**
+ * Whether the event being timed should be left out of the histograms, because
+ * it was not fully dispatched.
+ */
+static BOOL VELEventTimingCurrentEventSkipped = NO;
+
+/**
+ * Used to convert `mach_absolute_time()` units into nanoseconds.
+ */
+static mach_timebase_info_data_t VELEventTimingTimebase;
+
+/**
+ * Begins timing the dispatch of an event, if timing is enabled. Returns
+ * a start time to pass to <finishEventTiming>.
+ *
+ * If an event is already being timed, the time spent on any nested event is
+ * attributed to the outer one.
+ */
+static uint64_t beginEventTiming (void) {
+    if (!VELEventTimingEnabled && !VELEventTimingDepth)
+        return 0;
+
+    if (VELEventTimingDepth++ == 0) {
+        memset(VELEventTimingCurrentDurations, 0, sizeof(VELEventTimingCurrentDurations));
+        VELEventTimingCurrentPhases = 0;
+        VELEventTimingCurrentEventSkipped = NO;
+    }
+
+    return mach_absolute_time();
+}
+
+/**
+ * Returns the start time for one phase of event dispatch, or zero if no event
+ * is being timed.
+ */
+static inline uint64_t beginEventTimingPhase (void) {
+    return VELEventTimingDepth ? mach_absolute_time() : 0;
+}
+
+/**
+ * Adds the time since `start` to the duration of the given phase for the event
+ * being timed.
+ *
+ * @param phase The phase that just finished.
+ * @param start The value returned from <beginEventTimingPhase>.
+ */
+static inline void finishEventTimingPhase (VELEventTimingPhase phase, uint64_t start) {
+    if (!start)
+        return;
+
+    VELEventTimingCurrentDurations[phase] += mach_absolute_time() - start;
+    VELEventTimingCurrentPhases |= (1U << phase);
+}
+
+/**
+ * Marks the event being timed as not fully dispatched (for instance, because
+ * it was absorbed by an event recognizer, to be replayed later), so that its
+ * timings are not recorded.
+ */
+static inline void skipEventTiming (void) {
+    if (VELEventTimingDepth)
+        VELEventTimingCurrentEventSkipped = YES;
+}
+
+/**
+ * Atomically adds a duration to the given histogram.
+ *
+ * @param histogram The histogram to update.
+ * @param duration A duration in `mach_absolute_time()` units.
+ */
+static void recordEventTimingDuration (VELEventTimingHistogram *histogram, uint64_t duration) {
+    int64_t nanoseconds = (int64_t)(duration * VELEventTimingTimebase.numer / VELEventTimingTimebase.denom);
+    int64_t microseconds = nanoseconds / 1000;
+
+    unsigned bucket = 0;
+    while (microseconds > 0 && bucket < VELEventTimingBucketCount - 1) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+
+    OSAtomicIncrement64Barrier(&histogram->count);
+    OSAtomicAdd64Barrier(nanoseconds, &histogram->totalNanoseconds);
+    OSAtomicIncrement64Barrier(&histogram->buckets[bucket]);
+}
+
+/**
+ * Finishes timing the dispatch of an event. If this balances the outermost
+ * <beginEventTiming>, the durations of the event and all of its phases are
+ * recorded.
+ *
+ * @param type The type of the event that was dispatched.
+ * @param start The value returned from <beginEventTiming>.
+ */
+static void finishEventTiming (NSEventType type, uint64_t start) {
+    if (!start)
+        return;
+
+    uint64_t end = mach_absolute_time();
+
+    if (--VELEventTimingDepth > 0)
+        return;
+
+    if (VELEventTimingCurrentEventSkipped)
+        return;
+
+    if ((NSUInteger)type >= VELEventTimingEventTypeCount)
+        return;
+
+    VELEventTimingCurrentDurations[VELEventTimingPhaseTotal] = end - start;
+    VELEventTimingCurrentPhases |= (1U << VELEventTimingPhaseTotal);
+
+    for (unsigned phase = 0; phase < VELEventTimingPhaseCount; ++phase) {
+        if (!(VELEventTimingCurrentPhases & (1U << phase)))
+            continue;
+
+        recordEventTimingDuration(&VELEventTimingHistograms[type][phase], VELEventTimingCurrentDurations[phase]);
+    }
+}
+
+/**
+ * Hit tests the window of `event` at the event's location, returning the view
+ * which should receive it.
+ */
+static id<VELBridgedView> hitTestEvent (NSEvent *event) {
+    uint64_t start = beginEventTimingPhase();
+    id<VELBridgedView> view = [event.window bridgedHitTest:event.locationInWindow withEvent:event];
+    finishEventTimingPhase(VELEventTimingPhaseHitTest, start);
+
+    return view;
+}
+
+/**
+ * The `NSResponder` methods that events can be dispatched to, as indices into
+ * <VELResponderEventSelectors>.
+ */
+typedef enum {
+    VELResponderEventMouseDown,
+    VELResponderEventMouseUp,
+    VELResponderEventRightMouseDown,
+    VELResponderEventRightMouseUp,
+    VELResponderEventMouseMoved,
+    VELResponderEventMouseDragged,
+    VELResponderEventRightMouseDragged,
+    VELResponderEventMouseEntered,
+    VELResponderEventMouseExited,
+    VELResponderEventOtherMouseDown,
+    VELResponderEventOtherMouseUp,
+    VELResponderEventOtherMouseDragged,
+    VELResponderEventScrollWheel,
+    VELResponderEventMagnify,
+    VELResponderEventSwipe,
+    VELResponderEventRotate,
+    VELResponderEventBeginGesture,
+    VELResponderEventEndGesture,
+    VELResponderEventKeyDown,
+    VELResponderEventKeyUp,
+    VELResponderEventFlagsChanged,
+
+    VELResponderEventCount,
+    VELResponderEventNone = VELResponderEventCount
+} VELResponderEvent;
+
+/**
+ * The selector of the `NSResponder` method for each <VELResponderEvent>.
+ *
+ * This is filled in by `+[VELEventManager initialize]`.
+ */
+static SEL VELResponderEventSelectors[VELResponderEventCount];
+
+/**
+ * The function pointer to `NSResponder`'s implementation of each method in
+ * <VELResponderEventSelectors>.
+ *
+ * These are compared against the implementations of any responder classes to
+ * determine whether they override the method (instead of just passing the
+ * event to the next responder).
+ */
+static IMP VELResponderEventIMPs[VELResponderEventCount];
+
+/**
+ * Maps responder classes to a bitmask of the <VELResponderEvent> methods that
+ * they override.
+ *
+ * Keys and values are not retained. The values are bitmasks cast to pointers.
+ */
+static CFMutableDictionaryRef VELResponderClassOverriddenEvents = NULL;
+
+/**
+ * Returns the <VELResponderEvent> for the given event type, or
+ * `VELResponderEventNone` if events of that type are not dispatched to
+ * responders.
+ */
+static VELResponderEvent responderEventForEventType (NSEventType type) {
+    switch (type) {
+        case NSLeftMouseDown:
+            return VELResponderEventMouseDown;
+
+        case NSLeftMouseUp:
+            return VELResponderEventMouseUp;
+
+        case NSRightMouseDown:
+            return VELResponderEventRightMouseDown;
+
+        case NSRightMouseUp:
+            return VELResponderEventRightMouseUp;
+
+        case NSMouseMoved:
+            return VELResponderEventMouseMoved;
+
+        case NSLeftMouseDragged:
+            return VELResponderEventMouseDragged;
+
+        case NSRightMouseDragged:
+            return VELResponderEventRightMouseDragged;
+
+        case NSMouseEntered:
+            return VELResponderEventMouseEntered;
+
+        case NSMouseExited:
+            return VELResponderEventMouseExited;
+
+        case NSOtherMouseDown:
+            return VELResponderEventOtherMouseDown;
+
+        case NSOtherMouseUp:
+            return VELResponderEventOtherMouseUp;
+
+        case NSOtherMouseDragged:
+            return VELResponderEventOtherMouseDragged;
+
+        case NSScrollWheel:
+            return VELResponderEventScrollWheel;
+
+        case NSEventTypeMagnify:
+            return VELResponderEventMagnify;
+
+        case NSEventTypeSwipe:
+            return VELResponderEventSwipe;
+
+        case NSEventTypeRotate:
+            return VELResponderEventRotate;
+
+        case NSEventTypeBeginGesture:
+            return VELResponderEventBeginGesture;
+
+        case NSEventTypeEndGesture:
+            return VELResponderEventEndGesture;
+
+        case NSKeyDown:
+            return VELResponderEventKeyDown;
+
+        case NSKeyUp:
+            return VELResponderEventKeyUp;
+
+        case NSFlagsChanged:
+            return VELResponderEventFlagsChanged;
+
+        default:
+            return VELResponderEventNone;
+    }
+}
+
+/**
+ * Returns a bitmask of the <VELResponderEvent> methods that the given responder
+ * class overrides from `NSResponder`.
+ *
+ * The result is computed once per class, and cached thereafter.
+ */
+static uint32_t overriddenResponderEventsForClass (Class responderClass) {
+    const void *cachedMask = NULL;
+    if (CFDictionaryGetValueIfPresent(VELResponderClassOverriddenEvents, (__bridge const void *)responderClass, &cachedMask))
+        return (uint32_t)(uintptr_t)cachedMask;
+
+    uint32_t mask = 0;
+
+    for (unsigned i = 0; i < VELResponderEventCount; ++i) {
+        if (class_getMethodImplementation(responderClass, VELResponderEventSelectors[i]) != VELResponderEventIMPs[i])
+            mask |= (1U << i);
+    }
+
+    CFDictionarySetValue(VELResponderClassOverriddenEvents, (__bridge const void *)responderClass, (const void *)(uintptr_t)mask);
+    return mask;
+}
+
+/**
+ * Returns whether <[VELEventManager handleVelvetEvent:]> dispatches events of
+ * the given type to Velvet views itself, instead of leaving them to AppKit
+ * (which handles first responder events like key presses, including key
+ * equivalents and text input).
+ */
+static BOOL eventTypeIsDispatchedByVelvet (NSEventType type) {
+    switch (type) {
+        case NSLeftMouseDown:
+        case NSRightMouseDown:
+        case NSOtherMouseDown:
+        case NSLeftMouseUp:
+        case NSRightMouseUp:
+        case NSOtherMouseUp:
+        case NSLeftMouseDragged:
+        case NSRightMouseDragged:
+        case NSOtherMouseDragged:
+        case NSScrollWheel:
+        case NSEventTypeMagnify:
+        case NSEventTypeSwipe:
+        case NSEventTypeRotate:
+        case NSEventTypeBeginGesture:
+        case NSEventTypeEndGesture:
+            return YES;
+
+        default:
+            return NO;
+    }
+}
+
+/**
+ * Returns whether events of the given type can be coalesced by
+ * <[VELEventManager coalesceEvent:]>.
+ */
+static BOOL eventTypeIsCoalescible (NSEventType type) {
+    switch (type) {
+        case NSLeftMouseDragged:
+        case NSRightMouseDragged:
+        case NSOtherMouseDragged:
+        case NSScrollWheel:
+            return YES;
+
+        default:
+            return NO;
+    }
+}
+
+/**
+ * Returns a single event equivalent to `previous` followed by `latest`, or
+ * `nil` if the two events cannot be coalesced.
+ *
+ * The returned event is a copy of `latest`, with its deltas replaced by the sum
+ * of the deltas of both events.
+ *
+ * @param previous An event which has not yet been dispatched.
+ * @param latest An event which was received after `previous`.
+ */
+static NSEvent *coalescedEvent (NSEvent *previous, NSEvent *latest) {
+    if (latest.type != previous.type || !eventTypeIsCoalescible(latest.type))
+        return nil;
+
+    if (latest.window != previous.window || latest.modifierFlags != previous.modifierFlags)
+        return nil;
+
+    CGEventRef previousCGEvent = previous.CGEvent;
+    CGEventRef latestCGEvent = latest.CGEvent;
+    if (!previousCGEvent || !latestCGEvent)
+        return nil;
+
+    CGEventRef mergedCGEvent = CGEventCreateCopy(latestCGEvent);
+    if (!mergedCGEvent)
+        return nil;
+
+    @onExit {
+        CFRelease(mergedCGEvent);
+    };
+
+    if (latest.type == NSScrollWheel) {
+        // a scroll event goes to the view under the mouse, so only merge events
+        // that are guaranteed to have the same target, and which are part of
+        // the same gesture
+        if (!CGPointEqualToPoint(latest.locationInWindow, previous.locationInWindow))
+            return nil;
+
+        if (latest.phase != previous.phase || latest.momentumPhase != previous.momentumPhase)
+            return nil;
+
+        if (latest.hasPreciseScrollingDeltas != previous.hasPreciseScrollingDeltas)
+            return nil;
+
+        CGEventField integerFields[] = {
+            kCGScrollWheelEventDeltaAxis1,
+            kCGScrollWheelEventDeltaAxis2,
+            kCGScrollWheelEventPointDeltaAxis1,
+            kCGScrollWheelEventPointDeltaAxis2
+        };
+
+        for (size_t i = 0; i < sizeof(integerFields) / sizeof(*integerFields); ++i) {
+            int64_t sum = CGEventGetIntegerValueField(previousCGEvent, integerFields[i]) + CGEventGetIntegerValueField(latestCGEvent, integerFields[i]);
+            CGEventSetIntegerValueField(mergedCGEvent, integerFields[i], sum);
+        }
+
+        CGEventField fixedPointFields[] = {
+            kCGScrollWheelEventFixedPtDeltaAxis1,
+            kCGScrollWheelEventFixedPtDeltaAxis2
+        };
+
+        for (size_t i = 0; i < sizeof(fixedPointFields) / sizeof(*fixedPointFields); ++i) {
+            double sum = CGEventGetDoubleValueField(previousCGEvent, fixedPointFields[i]) + CGEventGetDoubleValueField(latestCGEvent, fixedPointFields[i]);
+            CGEventSetDoubleValueField(mergedCGEvent, fixedPointFields[i], sum);
+        }
+    } else {
+        // drags are always sent to the responder that received the mouse down,
+        // so they only need to have the same button
+        if (latest.buttonNumber != previous.buttonNumber)
+            return nil;
+
+        CGEventField fields[] = {
+            kCGMouseEventDeltaX,
+            kCGMouseEventDeltaY
+        };
+
+        for (size_t i = 0; i < sizeof(fields) / sizeof(*fields); ++i) {
+            double sum = CGEventGetDoubleValueField(previousCGEvent, fields[i]) + CGEventGetDoubleValueField(latestCGEvent, fields[i]);
+            CGEventSetDoubleValueField(mergedCGEvent, fields[i], sum);
+        }
+    }
+
+    NSEvent *mergedEvent = [NSEvent eventWithCGEvent:mergedCGEvent];
+    if (mergedEvent.window != latest.window)
+        return nil;
+
+    return mergedEvent;
+}
+
 /**
  * Walks up the hierarchy of the given view, collecting all enabled event
  * recognizers into the given array.
@@ -97,19 +695,23 @@ static BOOL eventIsPreventedToRecognizer(NSEvent *event, VELEventRecognizer *rec
  * Dispatches the given event to the recognizers at and after the given index.
  * Returns whether the event should still be passed to the view.
  *
+ * Any recognizer which delays the event is told about `view`, so that the
+ * event can later be replayed directly to it.
+ *
  * This function takes into account the value of <[VELEventRecognizer
  * handlesEventsAfterDescendants]>, to make sure that ancestors with that flag
  * enabled are only invoked after the rest of the recognizers (the descendants)
  * have received the event.
  *
  * @param event The event to dispatch.
+ * @param view The view that `event` is destined for, after the recognizers.
  * @param recognizers An array of event recognizers, with ancestors at the
  * beginning of the array. This will be modified by this function, so that
  * prevented recognizers are removed.
  * @param index The index into `recognizers` at which to begin event dispatch.
  * If this index is out-of-bounds, the function returns `YES` immediately.
  */
-static BOOL dispatchEventToRecognizersStartingAtIndex (NSEvent *event, NSMutableArray *recognizers, NSInteger index) {
+static BOOL dispatchEventToRecognizersStartingAtIndex (NSEvent *event, id<VELBridgedView> view, NSMutableArray *recognizers, NSInteger index) {
     NSCParameterAssert(event);
     NSCParameterAssert(recognizers);
 
@@ -122,33 +724,98 @@ static BOOL dispatchEventToRecognizersStartingAtIndex (NSEvent *event, NSMutable
     BOOL handlesAfterDescendants = recognizer.handlesEventsAfterDescendants;
     if (handlesAfterDescendants) {
         // dispatch to descendants first
-        dispatchToView &= dispatchEventToRecognizersStartingAtIndex(event, recognizers, index + 1);
+        dispatchToView &= dispatchEventToRecognizersStartingAtIndex(event, view, recognizers, index + 1);
     }
 
-    if (eventIsPreventedToRecognizer(event, recognizer, recognizers)) {
+    uint64_t preventionStart = beginEventTimingPhase();
+    BOOL prevented = eventIsPreventedToRecognizer(event, recognizer, recognizers);
+    finishEventTimingPhase(VELEventTimingPhasePreventionChecks, preventionStart);
+
+    if (prevented) {
         [recognizers removeObjectAtIndex:index--];
     } else if (!recognizer.shouldReceiveEventBlock || recognizer.shouldReceiveEventBlock(event)) {
-        if ([recognizer.eventsToIgnore containsObject:event]) {
-            [recognizer.eventsToIgnore removeObject:event];
-        } else {
-            BOOL handled = [recognizer handleEvent:event];
-
-            // don't forward the event to the view if this recognizer wants it
-            // delayed
-            if (handled && recognizer.delaysEventDelivery)
-                dispatchToView = NO;
+        uint64_t handlingStart = beginEventTimingPhase();
+        BOOL handled = [recognizer handleEvent:event];
+        finishEventTimingPhase(VELEventTimingPhaseRecognizerHandling, handlingStart);
+
+        // don't forward the event to the view if this recognizer wants it
+        // delayed
+        if (handled && recognizer.delaysEventDelivery) {
+            [recognizer setDelayedEventTarget:view forEvent:event];
+            dispatchToView = NO;
         }
     }
 
     if (!handlesAfterDescendants) {
         // dispatch to descendants after this recognizer has had a chance to
         // process the event
-        dispatchToView &= dispatchEventToRecognizersStartingAtIndex(event, recognizers, index + 1);
+        dispatchToView &= dispatchEventToRecognizersStartingAtIndex(event, view, recognizers, index + 1);
     }
 
     return dispatchToView;
 }
 
+/**
+ * Returns a fingerprint for the given mouse event.
+ *
+ * @param event A mouse event.
+ */
+static VELMouseEventFingerprint mouseEventFingerprint (NSEvent *event) {
+    NSCParameterAssert(event);
+
+    CGPoint location = event.locationInWindow;
+
+    return (VELMouseEventFingerprint){
+        .type = event.type,
+        .buttonNumber = event.buttonNumber,
+        .windowNumber = event.windowNumber,
+        .x = lround(location.x * VELMouseEventFingerprintLocationScale),
+        .y = lround(location.y * VELMouseEventFingerprintLocationScale),
+        .timestamp = event.timestamp,
+        .previousInBucket = NSNotFound
+    };
+}
+
+/**
+ * Returns the bucket that the given fingerprint should be chained into.
+ *
+ * Location isn't included, since two matching fingerprints may be quantized to
+ * neighboring values.
+ *
+ * @param fingerprint A mouse event fingerprint.
+ */
+static NSUInteger mouseEventFingerprintBucket (const VELMouseEventFingerprint *fingerprint) {
+    NSUInteger hash = (NSUInteger)fingerprint->type;
+    hash = hash * 31 + (NSUInteger)fingerprint->buttonNumber;
+    hash = hash * 31 + (NSUInteger)fingerprint->windowNumber;
+
+    return hash & (VELMouseEventDeduplicationBucketCount - 1);
+}
+
+/**
+ * Returns whether the two given mouse event fingerprints are the "same" and can
+ * be deduplicated.
+ *
+ * @param left One mouse event fingerprint.
+ * @param right Another mouse event fingerprint.
+ */
+static BOOL mouseEventFingerprintsMatch (const VELMouseEventFingerprint *left, const VELMouseEventFingerprint *right) {
+    if (!left->type || left->type != right->type)
+        return NO;
+
+    if (left->buttonNumber != right->buttonNumber)
+        return NO;
+
+    if (left->windowNumber != right->windowNumber)
+        return NO;
+
+    // allow for rounding across a quantization boundary
+    if (labs(left->x - right->x) > 1 || labs(left->y - right->y) > 1)
+        return NO;
+
+    return fabs(left->timestamp - right->timestamp) < VELMouseEventDeduplicationTimestampTolerance;
+}
+
 /**
  * Returns whether the two given mouse events are the "same" and can be
  * deduplicated.
@@ -157,22 +824,96 @@ static BOOL dispatchEventToRecognizersStartingAtIndex (NSEvent *event, NSMutable
  * @param right Another mouse event.
  */
 static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
-    if (left.type != right.type)
+    if (!left || !right)
         return NO;
 
-    if (left.buttonNumber != right.buttonNumber)
-        return NO;
+    VELMouseEventFingerprint leftFingerprint = mouseEventFingerprint(left);
+    VELMouseEventFingerprint rightFingerprint = mouseEventFingerprint(right);
 
-    if (left.window != right.window)
-        return NO;
+    return mouseEventFingerprintsMatch(&leftFingerprint, &rightFingerprint);
+}
 
-    if (!CGPointEqualToPointWithAccuracy(left.locationInWindow, right.locationInWindow, 0.01))
-        return NO;
+@interface VELEventManager () {
+    /**
+     * A ring buffer of fingerprints for mouse events that have already been
+     * received, which may be associated with future `NSSystemDefined` events
+     * to ignore.
+     *
+     * In other words, this buffer describes mouse events which should _not_ be
+     * synthesized and dispatched from an `NSSystemDefined` event.
+     *
+     * Fingerprints are stored in the order they were received, which is also
+     * timestamp order, so stale entries are always at the start of the buffer.
+     * Each fingerprint is identified by a sequence number, and stored at that
+     * number modulo <VELMouseEventDeduplicationCapacity>.
+     */
+    VELMouseEventFingerprint m_mouseEventsToDeduplicate[VELMouseEventDeduplicationCapacity];
+
+    /**
+     * For each bucket returned by <mouseEventFingerprintBucket>, the sequence
+     * number of the newest fingerprint in that bucket, or `NSNotFound`.
+     *
+     * Older fingerprints in the same bucket are chained through their
+     * `previousInBucket` field. Any sequence number below
+     * `m_mouseEventsToDeduplicateOldest` refers to a fingerprint which has been
+     * purged, and ends the chain.
+     */
+    NSUInteger m_mouseEventBucketHeads[VELMouseEventDeduplicationBucketCount];
+
+    /**
+     * For each <VELResponderEvent>, the responder that events dispatched to
+     * <eventHandlersView> should be sent to, as found by
+     * <responderForEvent:fromView:>.
+     *
+     * An entry is only valid if its bit is set in `m_eventHandlersMask`. If
+     * its bit is also set in `m_eventHandlersUseNextResponderMask`, the entry
+     * is the last Velvet responder in the chain, and events should go to its
+     * `nextResponder` instead.
+     *
+     * These entries are not retained, so that the cache doesn't keep views
+     * alive after they're removed. Only <VELView> and <VELViewController>
+     * instances (or <eventHandlersView> itself) are stored, and any change to
+     * them -- including deallocation -- changes <[VELView
+     * responderChainGeneration]>, which invalidates the cache.
+     */
+    __unsafe_unretained id m_eventHandlers[VELResponderEventCount];
+
+    /**
+     * A bitmask of the entries in `m_eventHandlers` which have been looked up.
+     */
+    uint32_t m_eventHandlersMask;
+
+    /**
+     * A bitmask of the entries in `m_eventHandlers` which should be replaced
+     * with their `nextResponder`.
+     */
+    uint32_t m_eventHandlersUseNextResponderMask;
+
+    /**
+     * The value of <[VELView responderChainGeneration]> when the entries in
+     * `m_eventHandlers` were looked up.
+     */
+    NSUInteger m_eventHandlersGeneration;
 
-    return fabs(left.timestamp - right.timestamp) < 0.1;
+    /**
+     * The sequence number of the oldest fingerprint in
+     * `m_mouseEventsToDeduplicate`.
+     */
+    NSUInteger m_mouseEventsToDeduplicateOldest;
+
+    /**
+     * The sequence number to assign to the next fingerprint added to
+     * `m_mouseEventsToDeduplicate`.
+     */
+    NSUInteger m_mouseEventsToDeduplicateNext;
+
+    /**
+     * The value of `VELWindowOrderingGeneration` when <windowLookupIndex> was
+     * built.
+     */
+    NSUInteger m_windowLookupIndexGeneration;
 }
 
-@interface VELEventManager ()
 /**
  * Any Velvet-hosted responder currently handling a continuous gesture event.
  */
@@ -190,6 +931,44 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
  */
 @property (nonatomic, weak) id lastMouseTrackingResponder;
 
+/**
+ * The region of the window, in window coordinates, within which
+ * <lastMouseTrackingResponder> is known to be the result of a hit test.
+ *
+ * This is the bounds of <lastMouseTrackingResponder> clipped to the bounds of
+ * all of its ancestors, or `CGRectNull` if no such region could be determined.
+ */
+@property (nonatomic, assign) CGRect lastMouseTrackingRect;
+
+/**
+ * The window number of the window that <lastMouseTrackingRect> is in.
+ */
+@property (nonatomic, assign) NSInteger lastMouseTrackingWindowNumber;
+
+/**
+ * The number of consecutive mouse tracking events for which the hit test was
+ * skipped, since the last full hit test.
+ */
+@property (nonatomic, assign) NSUInteger skippedMouseTrackingHitTestCount;
+
+/**
+ * The value of <[VELView hierarchyGeneration]> when <lastMouseTrackingRect> was
+ * determined.
+ */
+@property (nonatomic, assign) NSUInteger lastMouseTrackingHierarchyGeneration;
+
+/**
+ * Returns whether the given mouse tracking event can be sent to
+ * <lastMouseTrackingResponder> without performing a full hit test.
+ *
+ * This is the case if the event is inside <lastMouseTrackingRect>, and not
+ * inside any subview of the responder, and the view hierarchy hasn't changed
+ * since the last hit test.
+ *
+ * @param event A mouse tracking event which has a window.
+ */
+- (BOOL)canSkipHitTestForMouseTrackingEvent:(NSEvent *)event;
+
 /**
  * Whether an event is currently in the process of being handled in
  * <handleVelvetEvent:>.
@@ -200,15 +979,141 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
 @property (nonatomic, assign, getter = isHandlingEvent) BOOL handlingEvent;
 
 /**
- * Mouse events that have already been received that may be associated with
- * future `NSSystemDefined` events to ignore.
+ * Removes any mouse events from the deduplication buffer that are stale
+ * relative to the given timestamp.
+ *
+ * @param timestamp The timestamp of the event currently being handled.
+ */
+- (void)purgeMouseEventsToDeduplicateBeforeTimestamp:(NSTimeInterval)timestamp;
+
+/**
+ * Adds the given mouse event to the deduplication buffer, so that any
+ * matching `NSSystemDefined` event received later will be ignored.
  *
- * In other words, this array contains mouse events which should _not_ be
- * synthesized and dispatched from an `NSSystemDefined` event.
+ * If the buffer is full, the oldest event in it is forgotten.
  *
- * Outdated events in this array will be removed periodically.
+ * @param event A mouse event.
  */
-@property (nonatomic, strong, readonly) NSMutableArray *mouseEventsToDeduplicate;
+- (void)addMouseEventToDeduplicate:(NSEvent *)event;
+
+/**
+ * Finds a mouse event in the deduplication buffer which is effectively the
+ * same as the given event. If one is found, it is removed from the buffer, and
+ * `YES` is returned.
+ *
+ * @param event A mouse event synthesized from an `NSSystemDefined` event.
+ */
+- (BOOL)removeMouseEventToDeduplicateMatchingEvent:(NSEvent *)event;
+
+/**
+ * Whether an event is currently being dispatched to event recognizers in
+ * <dispatchEvent:toEventRecognizersForView:>.
+ *
+ * While this is `YES`, replayed events are queued instead of being delivered
+ * immediately.
+ */
+@property (nonatomic, assign, getter = isDispatchingToEventRecognizers) BOOL dispatchingToEventRecognizers;
+
+/**
+ * Delayed events waiting to be replayed by <replayQueuedEvents>, in order.
+ */
+@property (nonatomic, strong, readonly) NSMutableArray *replayQueueEvents;
+
+/**
+ * The target of each event in <replayQueueEvents>, at the same index, or
+ * `NSNull` if the event has no Velvet target.
+ */
+@property (nonatomic, strong, readonly) NSMutableArray *replayQueueTargets;
+
+/**
+ * Whether <replayQueuedEvents> is currently delivering events.
+ */
+@property (nonatomic, assign, getter = isReplayingEvents) BOOL replayingEvents;
+
+/**
+ * An event being handed back to AppKit by <replayEvent:toView:>, which Velvet
+ * should not process again if it comes back through the event monitor.
+ */
+@property (nonatomic, weak) NSEvent *eventPassingThrough;
+
+/**
+ * Delivers all events in <replayQueueEvents>, in order, using
+ * <replayEvent:toView:>.
+ */
+- (void)replayQueuedEvents;
+
+/**
+ * Dispatches a previously delayed event to the view that would originally have
+ * received it, without involving any event recognizers.
+ *
+ * @param event The event to replay.
+ * @param view The Velvet view which should receive `event`, or `NSNull` if
+ * AppKit should receive it instead.
+ */
+- (void)replayEvent:(NSEvent *)event toView:(id)view;
+
+/**
+ * Hands the given event directly to AppKit using `-[NSApplication sendEvent:]`,
+ * without letting Velvet process it again.
+ *
+ * @param event An event which Velvet did not handle.
+ */
+- (void)sendEventToAppKit:(NSEvent *)event;
+
+/**
+ * An event (possibly the result of merging several) which has been held back
+ * by <coalesceEvent:>, and has not yet been dispatched.
+ */
+@property (nonatomic, strong) NSEvent *pendingCoalescedEvent;
+
+/**
+ * The Velvet responder that <pendingCoalescedEvent> will be dispatched to.
+ * Events are only merged if they have the same target.
+ */
+@property (nonatomic, strong) id pendingCoalescedEventTarget;
+
+/**
+ * Returns the responder that the given coalescible event would be dispatched
+ * to, if it would be handled by Velvet, or `nil` otherwise.
+ *
+ * @param event A drag or scroll event.
+ */
+- (id)coalescingTargetForEvent:(NSEvent *)event;
+
+/**
+ * Enqueues a block to invoke <flushCoalescedEvent> once the main thread is
+ * idle, if one has not been enqueued already.
+ */
+- (void)scheduleCoalescedEventFlush;
+
+/**
+ * Whether a block has been enqueued to invoke <flushCoalescedEvent> at the end
+ * of the current run loop iteration.
+ */
+@property (nonatomic, assign, getter = isCoalescedEventFlushScheduled) BOOL coalescedEventFlushScheduled;
+
+/**
+ * Attempts to hold back the given event to be merged with any similar events
+ * that follow it. Returns whether the event was absorbed, in which case it
+ * should be hidden from AppKit.
+ *
+ * If the event cannot be merged with <pendingCoalescedEvent>, the pending
+ * event is dispatched first, so that the order of events is preserved.
+ *
+ * Only events which target a Velvet responder are held back. This does
+ * nothing if <coalescesContinuousEvents> is `NO`, or if the event is received
+ * while another event is being handled (e.g., in a nested tracking loop), or
+ * is being handed back to AppKit.
+ *
+ * @param event The event received by the local event monitor.
+ */
+- (BOOL)coalesceEvent:(NSEvent *)event;
+
+/**
+ * Dispatches <pendingCoalescedEvent>, if there is one, to Velvet or AppKit as
+ * appropriate.
+ */
+- (void)flushCoalescedEvent;
 
 /**
  * Turns an event into an `NSResponder` message, and attempts to send it to the
@@ -221,6 +1126,30 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
  */
 - (BOOL)dispatchEvent:(NSEvent *)event toBridgedView:(id<VELBridgedView>)view;
 
+/**
+ * The view that the responders in `m_eventHandlers` were looked up from.
+ *
+ * This is not retained, for the same reasons as `m_eventHandlers`. It's only
+ * ever compared against the view being dispatched to, so a dangling pointer
+ * can never be messaged.
+ */
+@property (nonatomic, unsafe_unretained) id eventHandlersView;
+
+/**
+ * Returns the first responder in the responder chain of `view` which should be
+ * sent `responderEvent`, or `nil` if the message should be sent to `view`
+ * itself.
+ *
+ * This skips over any Velvet views or view controllers which don't override the
+ * corresponding `NSResponder` method (and so would just pass the event along).
+ * Once the chain leaves Velvet, the remainder is left to AppKit. Results are
+ * cached until `view` or the Velvet responder chain changes.
+ *
+ * @param responderEvent The method which will be invoked.
+ * @param view The view that the event is being dispatched to.
+ */
+- (id)responderForEvent:(VELResponderEvent)responderEvent fromView:(id)view;
+
 /**
  * Dispatches the given event to all of the event recognizers that are directly
  * or indirectly attached to the given view. Returns whether the event should
@@ -266,12 +1195,59 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
  */
 - (void)handleMouseTrackingEvent:(NSEvent *)event;
 
+/**
+ * Updates <lastMouseTrackingRect> and <lastMouseTrackingWindowNumber> to
+ * describe where the given view will be hit in its window.
+ *
+ * Only Velvet views are cached. For any other view, the tracking rectangle is
+ * set to `CGRectNull`. Since a hit test inside a subview of the cached view
+ * would return a descendant instead, <canSkipHitTestForMouseTrackingEvent:>
+ * separately checks that the event is outside of all subviews.
+ *
+ * @param view The view most recently returned by a mouse tracking hit test, or
+ * `nil`.
+ * @param window The window containing `view`.
+ */
+- (void)updateMouseTrackingRectForView:(id)view inWindow:(NSWindow *)window;
+
+/**
+ * The application's visible windows, ordered from front to back, used to find
+ * the window for events without one.
+ *
+ * This is rebuilt lazily after being invalidated by
+ * <invalidateWindowLookupIndex:>. Windows which have been ordered out since
+ * the index was built may still be present, and must be checked for
+ * visibility.
+ */
+@property (nonatomic, copy, readonly) NSArray *windowLookupIndex;
+
+/**
+ * Throws away <windowLookupIndex>, so that it's rebuilt the next time it's
+ * needed.
+ *
+ * This is invoked for any notification that may indicate a change in the
+ * order or visibility of the application's windows. The index is also rebuilt
+ * whenever any window is ordered with `-[NSWindow orderWindow:relativeTo:]`
+ * (which `orderFront:`, `orderBack:` and `orderOut:` also go through).
+ *
+ * @param notification The notification that was posted.
+ */
+- (void)invalidateWindowLookupIndex:(NSNotification *)notification;
+
+/**
+ * Returns the frontmost window in <windowLookupIndex> which is visible and
+ * contains the given point, or `nil` if there is no such window.
+ *
+ * @param screenPoint A point in screen coordinates.
+ */
+- (NSWindow *)windowLookupIndexWindowAtScreenPoint:(CGPoint)screenPoint;
+
 /**
  * If the given event doesn't have an associated window, give it one, and update
  * its location accordingly.
  *
- * This currently just uses the application's `keyWindow` as the receiver, no
- * matter where the event is.
+ * The window chosen is the frontmost visible window of the application which
+ * contains the event's location.
  *
  * @param event The event that may have a `nil` window.
  */
@@ -295,10 +1271,95 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
 @synthesize currentMouseDownResponder = m_currentMouseDownResponder;
 @synthesize handlingEvent = m_handlingEvent;
 @synthesize lastMouseTrackingResponder = m_lastMouseTrackingResponder;
-@synthesize mouseEventsToDeduplicate = m_mouseEventsToDeduplicate;
+@synthesize lastMouseTrackingRect = m_lastMouseTrackingRect;
+@synthesize lastMouseTrackingWindowNumber = m_lastMouseTrackingWindowNumber;
+@synthesize skippedMouseTrackingHitTestCount = m_skippedMouseTrackingHitTestCount;
+@synthesize lastMouseTrackingHierarchyGeneration = m_lastMouseTrackingHierarchyGeneration;
+@synthesize windowLookupIndex = m_windowLookupIndex;
+@synthesize eventHandlersView = m_eventHandlersView;
+@synthesize coalescesContinuousEvents = m_coalescesContinuousEvents;
+@synthesize pendingCoalescedEvent = m_pendingCoalescedEvent;
+@synthesize pendingCoalescedEventTarget = m_pendingCoalescedEventTarget;
+@synthesize coalescedEventFlushScheduled = m_coalescedEventFlushScheduled;
+@synthesize dispatchingToEventRecognizers = m_dispatchingToEventRecognizers;
+@synthesize replayQueueEvents = m_replayQueueEvents;
+@synthesize replayQueueTargets = m_replayQueueTargets;
+@synthesize replayingEvents = m_replayingEvents;
+@synthesize eventPassingThrough = m_eventPassingThrough;
+
+- (BOOL)recordsEventDispatchTimings {
+    return VELEventTimingEnabled;
+}
+
+- (void)setRecordsEventDispatchTimings:(BOOL)records {
+    VELEventTimingEnabled = records;
+}
+
+- (void)setCoalescesContinuousEvents:(BOOL)coalesces {
+    m_coalescesContinuousEvents = coalesces;
+
+    if (!coalesces)
+        [self flushCoalescedEvent];
+}
+
+- (NSArray *)windowLookupIndex {
+    if (!m_windowLookupIndex || m_windowLookupIndexGeneration != VELWindowOrderingGeneration) {
+        // unlike -[NSApplication orderedWindows], this includes panels
+        NSArray *windowNumbers = [NSWindow windowNumbersWithOptions:0];
+        NSMutableArray *windows = [NSMutableArray arrayWithCapacity:windowNumbers.count];
+
+        for (NSNumber *windowNumber in windowNumbers) {
+            NSWindow *window = [NSApp windowWithWindowNumber:windowNumber.integerValue];
+            if (window)
+                [windows addObject:window];
+        }
+
+        m_windowLookupIndex = [windows copy];
+        m_windowLookupIndexGeneration = VELWindowOrderingGeneration;
+    }
+
+    return m_windowLookupIndex;
+}
 
 #pragma mark Lifecycle
 
++ (void)initialize {
+    if (self != [VELEventManager class])
+        return;
+
+    VELResponderEventSelectors[VELResponderEventMouseDown] = @selector(mouseDown:);
+    VELResponderEventSelectors[VELResponderEventMouseUp] = @selector(mouseUp:);
+    VELResponderEventSelectors[VELResponderEventRightMouseDown] = @selector(rightMouseDown:);
+    VELResponderEventSelectors[VELResponderEventRightMouseUp] = @selector(rightMouseUp:);
+    VELResponderEventSelectors[VELResponderEventMouseMoved] = @selector(mouseMoved:);
+    VELResponderEventSelectors[VELResponderEventMouseDragged] = @selector(mouseDragged:);
+    VELResponderEventSelectors[VELResponderEventRightMouseDragged] = @selector(rightMouseDragged:);
+    VELResponderEventSelectors[VELResponderEventMouseEntered] = @selector(mouseEntered:);
+    VELResponderEventSelectors[VELResponderEventMouseExited] = @selector(mouseExited:);
+    VELResponderEventSelectors[VELResponderEventOtherMouseDown] = @selector(otherMouseDown:);
+    VELResponderEventSelectors[VELResponderEventOtherMouseUp] = @selector(otherMouseUp:);
+    VELResponderEventSelectors[VELResponderEventOtherMouseDragged] = @selector(otherMouseDragged:);
+    VELResponderEventSelectors[VELResponderEventScrollWheel] = @selector(scrollWheel:);
+    VELResponderEventSelectors[VELResponderEventMagnify] = @selector(magnifyWithEvent:);
+    VELResponderEventSelectors[VELResponderEventSwipe] = @selector(swipeWithEvent:);
+    VELResponderEventSelectors[VELResponderEventRotate] = @selector(rotateWithEvent:);
+    VELResponderEventSelectors[VELResponderEventBeginGesture] = @selector(beginGestureWithEvent:);
+    VELResponderEventSelectors[VELResponderEventEndGesture] = @selector(endGestureWithEvent:);
+    VELResponderEventSelectors[VELResponderEventKeyDown] = @selector(keyDown:);
+    VELResponderEventSelectors[VELResponderEventKeyUp] = @selector(keyUp:);
+    VELResponderEventSelectors[VELResponderEventFlagsChanged] = @selector(flagsChanged:);
+
+    // save NSResponder's implementations so we can differentiate them from
+    // those of any subclasses
+    for (unsigned i = 0; i < VELResponderEventCount; ++i) {
+        VELResponderEventIMPs[i] = class_getMethodImplementation([NSResponder class], VELResponderEventSelectors[i]);
+    }
+
+    VELResponderClassOverriddenEvents = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+
+    mach_timebase_info(&VELEventTimingTimebase);
+}
+
 + (void)load {
     // set up a global event recognizer for VELHostView debug mode
     #ifdef DEBUG
@@ -334,7 +1395,18 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
         [recognizer handleEvent:event];
         #endif
 
-        if ([[self defaultManager] handleVelvetEvent:event])
+        // held back events are timed when they're eventually dispatched, so
+        // that a merged event only counts once
+        VELEventManager *manager = [self defaultManager];
+        if ([manager coalesceEvent:event])
+            return nil;
+
+        uint64_t timingStart = beginEventTiming();
+        @onExit {
+            finishEventTiming(event.type, timingStart);
+        };
+
+        if ([manager handleVelvetEvent:event])
             return nil;
         else
             return event;
@@ -357,126 +1429,222 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
     if (!self)
         return nil;
 
-    m_mouseEventsToDeduplicate = [NSMutableArray array];
-    return self;
-}
-
-#pragma mark Event handling
-
-- (BOOL)dispatchEvent:(NSEvent *)event toBridgedView:(id<VELBridgedView>)view; {
-    NSAssert([view isKindOfClass:[NSResponder class]], @"View %@ is not an NSResponder", view);
+    m_replayQueueEvents = [NSMutableArray array];
+    m_replayQueueTargets = [NSMutableArray array];
+    m_lastMouseTrackingRect = CGRectNull;
 
-    SEL action = NULL;
-
-    switch ([event type]) {
-        case NSLeftMouseDown:
-            action = @selector(mouseDown:);
-            break;
+    for (NSUInteger i = 0; i < VELMouseEventDeduplicationBucketCount; ++i) {
+        m_mouseEventBucketHeads[i] = NSNotFound;
+    }
 
-        case NSLeftMouseUp:
-            action = @selector(mouseUp:);
-            break;
+    NSArray *windowOrderingNotifications = [NSArray arrayWithObjects:
+        NSWindowDidBecomeKeyNotification,
+        NSWindowDidBecomeMainNotification,
+        NSWindowDidMiniaturizeNotification,
+        NSWindowDidDeminiaturizeNotification,
+        NSWindowDidExposeNotification,
+        NSWindowWillCloseNotification,
+        NSApplicationDidBecomeActiveNotification,
+        NSApplicationDidResignActiveNotification,
+        NSApplicationDidHideNotification,
+        NSApplicationDidUnhideNotification,
+        nil
+    ];
 
-        case NSRightMouseDown:
-            action = @selector(rightMouseDown:);
-            break;
+    for (NSString *name in windowOrderingNotifications) {
+        [[NSNotificationCenter defaultCenter]
+            addObserver:self
+            selector:@selector(invalidateWindowLookupIndex:)
+            name:name
+            object:nil
+        ];
+    }
 
-        case NSRightMouseUp:
-            action = @selector(rightMouseUp:);
-            break;
+    return self;
+}
 
-        case NSMouseMoved:
-            action = @selector(mouseMoved:);
-            break;
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
 
-        case NSLeftMouseDragged:
-            action = @selector(mouseDragged:);
-            break;
+#pragma mark Event handling
 
-        case NSRightMouseDragged:
-            action = @selector(rightMouseDragged:);
-            break;
+- (BOOL)dispatchEvent:(NSEvent *)event toBridgedView:(id<VELBridgedView>)view; {
+    NSAssert([view isKindOfClass:[NSResponder class]], @"View %@ is not an NSResponder", view);
 
-        case NSMouseEntered:
-            action = @selector(mouseEntered:);
-            break;
+    VELResponderEvent responderEvent = responderEventForEventType(event.type);
+    if (responderEvent == VELResponderEventNone) {
+        NSLog(@"*** Unrecognized event: %@", event);
+        return NO;
+    }
 
-        case NSMouseExited:
-            action = @selector(mouseExited:);
-            break;
+    uint64_t start = beginEventTimingPhase();
+    @onExit {
+        finishEventTimingPhase(VELEventTimingPhaseViewDispatch, start);
+    };
 
-        case NSOtherMouseDown:
-            action = @selector(otherMouseDown:);
-            break;
+    id responder = [self responderForEvent:responderEvent fromView:view] ?: view;
+    return [responder tryToPerform:VELResponderEventSelectors[responderEvent] with:event];
+}
 
-        case NSOtherMouseUp:
-            action = @selector(otherMouseUp:);
-            break;
+- (id)responderForEvent:(VELResponderEvent)responderEvent fromView:(id)view; {
+    NSParameterAssert(responderEvent < VELResponderEventCount);
 
-        case NSOtherMouseDragged:
-            action = @selector(otherMouseDragged:);
-            break;
-        
-        case NSScrollWheel:
-            action = @selector(scrollWheel:);
-            break;
+    NSUInteger generation = [VELView responderChainGeneration];
 
-        case NSEventTypeMagnify:
-            action = @selector(magnifyWithEvent:);
-            break;
+    if (view != self.eventHandlersView || generation != m_eventHandlersGeneration) {
+        for (unsigned i = 0; i < VELResponderEventCount; ++i) {
+            m_eventHandlers[i] = nil;
+        }
 
-        case NSEventTypeSwipe:
-            action = @selector(swipeWithEvent:);
-            break;
+        m_eventHandlersMask = 0;
+        m_eventHandlersUseNextResponderMask = 0;
+        m_eventHandlersGeneration = generation;
+        self.eventHandlersView = view;
+    }
 
-        case NSEventTypeRotate:
-            action = @selector(rotateWithEvent:);
-            break;
+    uint32_t bit = (1U << responderEvent);
+    if (m_eventHandlersMask & bit) {
+        id responder = m_eventHandlers[responderEvent];
 
-        case NSEventTypeBeginGesture:
-            action = @selector(beginGestureWithEvent:);
-            break;
+        if (m_eventHandlersUseNextResponderMask & bit)
+            return [responder nextResponder];
+        else
+            return responder;
+    }
 
-        case NSEventTypeEndGesture:
-            action = @selector(endGestureWithEvent:);
-            break;
+    id responder = view;
+    id lastVelvetResponder = nil;
 
-        case NSKeyDown:
-            action = @selector(keyDown:);
+    while (responder) {
+        // we only know when the chain changes for Velvet responders, so let
+        // -tryToPerform:with: handle everything after that
+        if (![responder isKindOfClass:[VELView class]] && ![responder isKindOfClass:[VELViewController class]])
             break;
 
-        case NSKeyUp:
-            action = @selector(keyUp:);
+        if (overriddenResponderEventsForClass(object_getClass(responder)) & bit)
             break;
 
-        case NSFlagsChanged:
-            action = @selector(flagsChanged:);
-            break;
+        lastVelvetResponder = responder;
+        responder = [responder nextResponder];
+    }
 
-        default:
-            NSLog(@"*** Unrecognized event: %@", event);
+    if (lastVelvetResponder && responder && ![responder isKindOfClass:[VELView class]] && ![responder isKindOfClass:[VELViewController class]]) {
+        // don't hold on to a responder whose lifetime we can't track; look it
+        // up from the last Velvet responder each time instead
+        m_eventHandlers[responderEvent] = lastVelvetResponder;
+        m_eventHandlersUseNextResponderMask |= bit;
+    } else {
+        m_eventHandlers[responderEvent] = responder;
     }
 
-    if (action)
-        return [(id)view tryToPerform:action with:event];
-    else
-        return NO;
+    m_eventHandlersMask |= bit;
+
+    return responder;
 }
 
 - (BOOL)dispatchEvent:(NSEvent *)event toEventRecognizersForView:(id<VELBridgedView>)view; {
     NSParameterAssert(event != nil);
     NSParameterAssert(view != nil);
 
+    uint64_t collectionStart = beginEventTimingPhase();
+
     NSMutableArray *recognizers = [NSMutableArray array];
     getEventRecognizersFromViewHierarchy(recognizers, view);
 
+    finishEventTimingPhase(VELEventTimingPhaseRecognizerCollection, collectionStart);
+
     if (!recognizers.count)
         return YES;
 
-    return dispatchEventToRecognizersStartingAtIndex(event, recognizers, 0);
+    BOOL wasDispatching = self.dispatchingToEventRecognizers;
+    self.dispatchingToEventRecognizers = YES;
+
+    BOOL dispatchToView = dispatchEventToRecognizersStartingAtIndex(event, view, recognizers, 0);
+
+    self.dispatchingToEventRecognizers = wasDispatching;
+
+    // deliver any events that were released by the recognizers, before the
+    // current event gets to the view
+    if (!wasDispatching)
+        [self replayQueuedEvents];
+
+    return dispatchToView;
+}
+
+- (void)replayDelayedEvents:(NSArray *)events targets:(NSArray *)targets; {
+    NSParameterAssert(events.count == targets.count);
+
+    [self.replayQueueEvents addObjectsFromArray:events];
+    [self.replayQueueTargets addObjectsFromArray:targets];
+
+    if (!self.dispatchingToEventRecognizers)
+        [self replayQueuedEvents];
+}
+
+- (void)replayQueuedEvents; {
+    // if we're already replaying, the loop below will pick up any new events
+    if (self.replayingEvents)
+        return;
+
+    self.replayingEvents = YES;
+    @onExit {
+        self.replayingEvents = NO;
+    };
+
+    while (self.replayQueueEvents.count) {
+        NSEvent *event = [self.replayQueueEvents objectAtIndex:0];
+        id view = [self.replayQueueTargets objectAtIndex:0];
+
+        [self.replayQueueEvents removeObjectAtIndex:0];
+        [self.replayQueueTargets removeObjectAtIndex:0];
+
+        [self replayEvent:event toView:view];
+    }
+}
+
+- (void)replayEvent:(NSEvent *)event toView:(id)view; {
+    BOOL velvetTarget = [view conformsToProtocol:@protocol(VELBridgedView)] && ![view isKindOfClass:[NSView class]];
+
+    // other events (like key presses) would've gone through AppKit even with
+    // a Velvet target, so that key equivalents and text input still work
+    if (velvetTarget && eventTypeIsDispatchedByVelvet(event.type)) {
+        switch (event.type) {
+            case NSLeftMouseDown:
+            case NSRightMouseDown:
+            case NSOtherMouseDown:
+                // this was skipped when the event was originally delayed
+                [event.window makeFirstResponder:view];
+                break;
+
+            default:
+                ;
+        }
+
+        [self dispatchEvent:event toBridgedView:view];
+        return;
+    }
+
+    // AppKit would've handled this event if it hadn't been delayed, so give it
+    // back without letting Velvet see it again
+    [self sendEventToAppKit:event];
+}
+
+- (void)sendEventToAppKit:(NSEvent *)event; {
+    self.eventPassingThrough = event;
+    @onExit {
+        self.eventPassingThrough = nil;
+    };
+
+    [NSApp sendEvent:event];
 }
 
 - (BOOL)handleVelvetEvent:(NSEvent *)event; {
+    if (event == self.eventPassingThrough) {
+        // this is an event being handed back to AppKit
+        return NO;
+    }
+
     if (self.handlingEvent) {
         // don't recurse -- see the description for this property
         return NO;
@@ -487,23 +1655,12 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
         self.handlingEvent = NO;
     };
 
-    // purge stale mouse events
-    NSTimeInterval currentTimestamp = event.timestamp;
-    NSMutableIndexSet *mouseEventsToRemove = [NSMutableIndexSet indexSet];
-
-    [self.mouseEventsToDeduplicate enumerateObjectsUsingBlock:^(NSEvent *event, NSUInteger index, BOOL *stop){
-        if (currentTimestamp > event.timestamp + VELMouseEventDeduplicationStalenessInterval) {
-            // this event is stale
-            [mouseEventsToRemove addIndex:index];
-        }
-    }];
-
-    [self.mouseEventsToDeduplicate removeObjectsAtIndexes:mouseEventsToRemove];
+    [self purgeMouseEventsToDeduplicateBeforeTimestamp:event.timestamp];
 
     // if this is a mouse event, make sure to deduplicate any NSSystemDefined
     // events coming afterward
     if (NSEventMaskFromType(event.type) & VELMouseEventMask) {
-        [self.mouseEventsToDeduplicate addObject:event];
+        [self addMouseEventToDeduplicate:event];
     }
 
     __block id respondingView = nil;
@@ -531,6 +1688,7 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
 
         if (![self dispatchEvent:event toEventRecognizersForView:respondingView]) {
             eventAbsorbedByRecognizer = YES;
+            skipEventTiming();
             return YES;
         }
 
@@ -544,7 +1702,7 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
         case NSLeftMouseDown:
         case NSRightMouseDown:
         case NSOtherMouseDown:
-            respondingView = [event.window bridgedHitTest:[event locationInWindow] withEvent:event];
+            respondingView = hitTestEvent(event);
             if (!dispatchToView()) {
                 self.currentMouseDownResponder = nil;
                 return NO;
@@ -585,11 +1743,11 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
         case NSEventTypeMagnify:
         case NSEventTypeSwipe:
         case NSEventTypeRotate:
-            respondingView = [event.window bridgedHitTest:[event locationInWindow] withEvent:event];
+            respondingView = hitTestEvent(event);
             break;
 
         case NSEventTypeBeginGesture:
-            respondingView = [event.window bridgedHitTest:[event locationInWindow] withEvent:event];
+            respondingView = hitTestEvent(event);
             if (velvetShouldHandleRespondingView()) {
                 self.currentGestureResponder = respondingView;
             }
@@ -619,8 +1777,10 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
 
             if ([view conformsToProtocol:@protocol(VELBridgedView)]) {
                 // dispatch to recognizers, and hide the event from AppKit if consumed
-                if (![self dispatchEvent:event toEventRecognizersForView:view])
+                if (![self dispatchEvent:event toEventRecognizersForView:view]) {
+                    skipEventTiming();
                     return YES;
+                }
             }
 
             return NO;
@@ -641,15 +1801,11 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
     BOOL consumed = NO;
     for (NSEvent *mouseEvent in mouseEvents) {
         NSEvent *windowedMouseEvent = [self mouseEventByAddingWindow:mouseEvent];
+        if (!windowedMouseEvent)
+            continue;
 
         // see if this is a duplicate of any previous mouse events
-        NSUInteger previousMouseEventIndex = [self.mouseEventsToDeduplicate indexOfObjectPassingTest:^(NSEvent *previousMouseEvent, NSUInteger index, BOOL *stop){
-            return mouseEventsAreEffectivelyTheSame(windowedMouseEvent, previousMouseEvent);
-        }];
-        
-        if (previousMouseEventIndex != NSNotFound) {
-            [self.mouseEventsToDeduplicate removeObjectAtIndex:previousMouseEventIndex];
-            
+        if ([self removeMouseEventToDeduplicateMatchingEvent:windowedMouseEvent]) {
             // don't dispatch this (duplicate) event
             continue;
         }
@@ -669,7 +1825,7 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
             continue;
         }
 
-        id<VELBridgedView> view = [windowedMouseEvent.window bridgedHitTest:windowedMouseEvent.locationInWindow withEvent:windowedMouseEvent];
+        id<VELBridgedView> view = hitTestEvent(windowedMouseEvent);
         if (!view)
             continue;
 
@@ -688,27 +1844,40 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
     return r.origin;
 }
 
+- (void)invalidateWindowLookupIndex:(NSNotification *)notification; {
+    m_windowLookupIndex = nil;
+}
+
+- (NSWindow *)windowLookupIndexWindowAtScreenPoint:(CGPoint)screenPoint; {
+    for (NSWindow *window in self.windowLookupIndex) {
+        if (![window isVisible])
+            continue;
+
+        if (CGRectContainsPoint(window.frame, screenPoint))
+            return window;
+    }
+
+    return nil;
+}
+
 - (NSEvent *)mouseEventByAddingWindow:(NSEvent *)event {
     if (!event || event.window)
         return event;
 
-    NSWindow *matchingWindow = nil;
-    CGPoint windowLocation;
-    
-    for (NSWindow *window in [NSApp windows]) {
-        if (![window isVisible])
-            continue;
+    CGPoint screenPoint = event.locationInWindow;
 
-        CGPoint screenPoint = event.locationInWindow;
-        if (!CGRectContainsPoint(window.frame, screenPoint))
-            continue;
+    NSWindow *matchingWindow = [self windowLookupIndexWindowAtScreenPoint:screenPoint];
+    if (!matchingWindow) {
+        // a window may have been ordered in without any notification we
+        // observe, so rebuild the index before giving up
+        [self invalidateWindowLookupIndex:nil];
 
-        matchingWindow = window;
-        windowLocation = [self convertScreenPoint:event.locationInWindow toWindow:window];
+        matchingWindow = [self windowLookupIndexWindowAtScreenPoint:screenPoint];
+        if (!matchingWindow)
+            return nil;
     }
 
-    if (!matchingWindow)
-        return nil;
+    CGPoint windowLocation = [self convertScreenPoint:screenPoint toWindow:matchingWindow];
 
     NSEvent *windowEvent = [NSEvent mouseEventWithType:event.type
         location:windowLocation
@@ -730,23 +1899,338 @@ static BOOL mouseEventsAreEffectivelyTheSame (NSEvent *left, NSEvent *right) {
     if (!event)
         return;
 
-    id hitView = [event.window bridgedHitTest:[event locationInWindow] withEvent:event];
-    if (hitView == self.lastMouseTrackingResponder) {
+    id lastResponder = self.lastMouseTrackingResponder;
+
+    // if the mouse is still within the last responder, skip the hit test, but
+    // periodically verify that nothing else has moved underneath the mouse
+    if ([self canSkipHitTestForMouseTrackingEvent:event]) {
+        ++self.skippedMouseTrackingHitTestCount;
+        [lastResponder tryToPerform:@selector(mouseMoved:) with:event];
+        return;
+    }
+
+    id hitView = hitTestEvent(event);
+    self.skippedMouseTrackingHitTestCount = 0;
+
+    if (hitView == lastResponder) {
+        [self updateMouseTrackingRectForView:hitView inWindow:event.window];
         [hitView tryToPerform:@selector(mouseMoved:) with:event];
         return;
     }
 
-    [self.lastMouseTrackingResponder tryToPerform:@selector(mouseExited:) with:event];
+    [lastResponder tryToPerform:@selector(mouseExited:) with:event];
 
     if ([hitView isKindOfClass:[NSView class]]) {
         self.lastMouseTrackingResponder = nil;
+        [self updateMouseTrackingRectForView:nil inWindow:event.window];
         return;
     }
 
     [event.window setAcceptsMouseMovedEvents:YES];
 
     self.lastMouseTrackingResponder = hitView;
+    [self updateMouseTrackingRectForView:hitView inWindow:event.window];
     [hitView tryToPerform:@selector(mouseEntered:) with:event];
 }
 
+- (BOOL)canSkipHitTestForMouseTrackingEvent:(NSEvent *)event; {
+    VELView *lastResponder = self.lastMouseTrackingResponder;
+    if (!lastResponder)
+        return NO;
+
+    if (self.skippedMouseTrackingHitTestCount >= VELMouseTrackingMaximumSkippedHitTests)
+        return NO;
+
+    if (event.windowNumber != self.lastMouseTrackingWindowNumber || self.lastMouseTrackingHierarchyGeneration != [VELView hierarchyGeneration])
+        return NO;
+
+    CGPoint windowPoint = event.locationInWindow;
+    if (!CGRectContainsPoint(self.lastMouseTrackingRect, windowPoint))
+        return NO;
+
+    NSArray *subviews = lastResponder.subviews;
+    if (!subviews.count)
+        return YES;
+
+    // a hit test would return the subview instead
+    CGPoint point = [lastResponder convertFromWindowPoint:windowPoint];
+    for (VELView *subview in subviews) {
+        if (CGRectContainsPoint(subview.frame, point))
+            return NO;
+    }
+
+    return YES;
+}
+
+- (void)updateMouseTrackingRectForView:(id)view inWindow:(NSWindow *)window; {
+    self.lastMouseTrackingWindowNumber = window.windowNumber;
+    self.lastMouseTrackingHierarchyGeneration = [VELView hierarchyGeneration];
+
+    if (![view isKindOfClass:[VELView class]]) {
+        self.lastMouseTrackingRect = CGRectNull;
+        return;
+    }
+
+    CGRect rect = [view convertToWindowRect:[view bounds]];
+
+    // hit testing only descends into views containing the point, so clip to
+    // the bounds of every ancestor
+    id<VELBridgedView> ancestor = [view immediateParentView];
+    while (ancestor && !CGRectIsNull(rect)) {
+        rect = CGRectIntersection(rect, [ancestor convertToWindowRect:[(id)ancestor bounds]]);
+        ancestor = ancestor.immediateParentView;
+    }
+
+    self.lastMouseTrackingRect = rect;
+}
+
+#pragma mark Event coalescing
+
+- (BOOL)coalesceEvent:(NSEvent *)event; {
+    if (!self.coalescesContinuousEvents)
+        return NO;
+
+    // events received while handling another one (like those in a nested
+    // -nextEventMatchingMask: loop), or being handed back to AppKit, must be
+    // delivered right away
+    if (self.handlingEvent || event == self.eventPassingThrough)
+        return NO;
+
+    id target = nil;
+    if (eventTypeIsCoalescible(event.type))
+        target = [self coalescingTargetForEvent:event];
+
+    if (self.pendingCoalescedEvent) {
+        if (target && target == self.pendingCoalescedEventTarget) {
+            NSEvent *mergedEvent = coalescedEvent(self.pendingCoalescedEvent, event);
+            if (mergedEvent) {
+                self.pendingCoalescedEvent = mergedEvent;
+                return YES;
+            }
+        }
+
+        // dispatch the pending event before this one
+        [self flushCoalescedEvent];
+    }
+
+    // leave anything not destined for Velvet alone
+    if (!target)
+        return NO;
+
+    self.pendingCoalescedEvent = event;
+    self.pendingCoalescedEventTarget = target;
+
+    [self scheduleCoalescedEventFlush];
+    return YES;
+}
+
+- (id)coalescingTargetForEvent:(NSEvent *)event; {
+    id target = nil;
+
+    switch (event.type) {
+        case NSLeftMouseDragged:
+        case NSRightMouseDragged:
+        case NSOtherMouseDragged:
+            target = (id)self.currentMouseDownResponder ?: [event.window firstResponder];
+            break;
+
+        case NSScrollWheel:
+            target = hitTestEvent(event);
+            break;
+
+        default:
+            return nil;
+    }
+
+    // matches the check in -handleVelvetEvent:
+    if (![target conformsToProtocol:@protocol(VELBridgedView)] || [target isKindOfClass:[NSView class]])
+        return nil;
+
+    return target;
+}
+
+- (void)scheduleCoalescedEventFlush; {
+    if (self.coalescedEventFlushScheduled)
+        return;
+
+    self.coalescedEventFlushScheduled = YES;
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        self.coalescedEventFlushScheduled = NO;
+
+        if (self.handlingEvent) {
+            // the pending event can't be dispatched to Velvet from inside
+            // another event, so wait until that one has finished
+            [self scheduleCoalescedEventFlush];
+            return;
+        }
+
+        [self flushCoalescedEvent];
+    });
+}
+
+- (void)flushCoalescedEvent; {
+    NSEvent *event = self.pendingCoalescedEvent;
+    if (!event)
+        return;
+
+    self.pendingCoalescedEvent = nil;
+    self.pendingCoalescedEventTarget = nil;
+
+    uint64_t timingStart = beginEventTiming();
+    @onExit {
+        finishEventTiming(event.type, timingStart);
+    };
+
+    if (![self handleVelvetEvent:event])
+        [self sendEventToAppKit:event];
+}
+
+#pragma mark Instrumentation
+
+- (NSDictionary *)eventDispatchTimings; {
+    NSString *phaseKeys[VELEventTimingPhaseCount] = {
+        [VELEventTimingPhaseHitTest] = VELEventDispatchPhaseHitTest,
+        [VELEventTimingPhaseRecognizerCollection] = VELEventDispatchPhaseRecognizerCollection,
+        [VELEventTimingPhasePreventionChecks] = VELEventDispatchPhasePreventionChecks,
+        [VELEventTimingPhaseRecognizerHandling] = VELEventDispatchPhaseRecognizerHandling,
+        [VELEventTimingPhaseViewDispatch] = VELEventDispatchPhaseViewDispatch,
+        [VELEventTimingPhaseTotal] = VELEventDispatchPhaseTotal
+    };
+
+    NSMutableDictionary *timings = [NSMutableDictionary dictionary];
+
+    for (NSUInteger type = 0; type < VELEventTimingEventTypeCount; ++type) {
+        NSMutableDictionary *phases = [NSMutableDictionary dictionary];
+
+        for (unsigned phase = 0; phase < VELEventTimingPhaseCount; ++phase) {
+            const VELEventTimingHistogram *histogram = &VELEventTimingHistograms[type][phase];
+
+            int64_t count = histogram->count;
+            if (!count)
+                continue;
+
+            NSMutableArray *buckets = [NSMutableArray arrayWithCapacity:VELEventTimingBucketCount];
+            for (unsigned i = 0; i < VELEventTimingBucketCount; ++i) {
+                [buckets addObject:[NSNumber numberWithLongLong:histogram->buckets[i]]];
+            }
+
+            NSDictionary *description = [NSDictionary dictionaryWithObjectsAndKeys:
+                [NSNumber numberWithLongLong:count], VELEventDispatchTimingCountKey,
+                [NSNumber numberWithDouble:histogram->totalNanoseconds / 1000.0], VELEventDispatchTimingTotalMicrosecondsKey,
+                buckets, VELEventDispatchTimingHistogramKey,
+                nil
+            ];
+
+            [phases setObject:description forKey:phaseKeys[phase]];
+        }
+
+        if (phases.count)
+            [timings setObject:phases forKey:[NSNumber numberWithUnsignedInteger:type]];
+    }
+
+    return timings;
+}
+
+- (void)resetEventDispatchTimings; {
+    memset(VELEventTimingHistograms, 0, sizeof(VELEventTimingHistograms));
+}
+
+- (BOOL)writeEventDispatchTimingsToURL:(NSURL *)URL error:(NSError **)error; {
+    NSParameterAssert(URL != nil);
+
+    // property list keys must be strings
+    NSMutableDictionary *timings = [NSMutableDictionary dictionary];
+    [self.eventDispatchTimings enumerateKeysAndObjectsUsingBlock:^(NSNumber *type, NSDictionary *phases, BOOL *stop){
+        [timings setObject:phases forKey:type.stringValue];
+    }];
+
+    NSData *data = [NSPropertyListSerialization dataWithPropertyList:timings format:NSPropertyListXMLFormat_v1_0 options:0 error:error];
+    if (!data)
+        return NO;
+
+    return [data writeToURL:URL options:NSDataWritingAtomic error:error];
+}
+
+#pragma mark Mouse event deduplication
+
+- (void)purgeMouseEventsToDeduplicateBeforeTimestamp:(NSTimeInterval)timestamp; {
+    while (m_mouseEventsToDeduplicateOldest < m_mouseEventsToDeduplicateNext) {
+        VELMouseEventFingerprint *oldest = m_mouseEventsToDeduplicate + (m_mouseEventsToDeduplicateOldest % VELMouseEventDeduplicationCapacity);
+
+        // matched fingerprints can be thrown away regardless of age
+        if (oldest->type && timestamp <= oldest->timestamp + VELMouseEventDeduplicationStalenessInterval)
+            break;
+
+        // any bucket chains leading here now end, since the sequence number
+        // is below the oldest one
+        ++m_mouseEventsToDeduplicateOldest;
+    }
+}
+
+- (void)addMouseEventToDeduplicate:(NSEvent *)event; {
+    NSParameterAssert(event);
+
+    if (m_mouseEventsToDeduplicateNext - m_mouseEventsToDeduplicateOldest == VELMouseEventDeduplicationCapacity) {
+        // overwrite the oldest fingerprint
+        ++m_mouseEventsToDeduplicateOldest;
+    }
+
+    VELMouseEventFingerprint fingerprint = mouseEventFingerprint(event);
+    NSUInteger bucket = mouseEventFingerprintBucket(&fingerprint);
+
+    NSUInteger sequence = m_mouseEventsToDeduplicateNext++;
+
+    fingerprint.previousInBucket = m_mouseEventBucketHeads[bucket];
+    m_mouseEventBucketHeads[bucket] = sequence;
+
+    m_mouseEventsToDeduplicate[sequence % VELMouseEventDeduplicationCapacity] = fingerprint;
+}
+
+- (BOOL)removeMouseEventToDeduplicateMatchingEvent:(NSEvent *)event; {
+    NSParameterAssert(event);
+
+    VELMouseEventFingerprint fingerprint = mouseEventFingerprint(event);
+    NSUInteger sequence = m_mouseEventBucketHeads[mouseEventFingerprintBucket(&fingerprint)];
+
+    // search the bucket from newest to oldest, stopping once fingerprints are
+    // purged or too old to match
+    while (sequence != NSNotFound && sequence >= m_mouseEventsToDeduplicateOldest) {
+        VELMouseEventFingerprint *previous = m_mouseEventsToDeduplicate + (sequence % VELMouseEventDeduplicationCapacity);
+        sequence = previous->previousInBucket;
+
+        if (previous->timestamp + VELMouseEventDeduplicationTimestampTolerance <= fingerprint.timestamp)
+            break;
+
+        if (mouseEventFingerprintsMatch(previous, &fingerprint)) {
+            // mark this fingerprint as matched, to be removed the next time
+            // the buffer is purged
+            previous->type = 0;
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+@end
+
+static void orderWindowInvalidatingWindowLookupIndex (NSWindow *self, SEL _cmd, NSWindowOrderingMode place, NSInteger otherWindowNumber) {
+    originalOrderWindowIMP(self, _cmd, place, otherWindowNumber);
+
+    // ordering a panel or other non-key window in front doesn't post any
+    // notification, so this is the only reliable way to keep the z-order
+    // current
+    ++VELWindowOrderingGeneration;
+}
+
+@implementation NSWindow (UnsafeVELEventManagerAdditions)
+
++ (void)load {
+    Method orderWindow = class_getInstanceMethod(self, @selector(orderWindow:relativeTo:));
+    originalOrderWindowIMP = (void (*)(id, SEL, NSWindowOrderingMode, NSInteger))method_getImplementation(orderWindow);
+
+    class_replaceMethod(self, method_getName(orderWindow), (IMP)&orderWindowInvalidatingWindowLookupIndex, method_getTypeEncoding(orderWindow));
+}
+
 @end
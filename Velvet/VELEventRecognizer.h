@@ -131,6 +131,19 @@ NSString *NSStringFromVELEventRecognizerState(VELEventRecognizerState state);
  */
 + (NSArray *)eventRecognizersForView:(id<VELBridgedView>)view;
 
+/**
+ * Attaches all of the given event recognizers to `view`, as if the <view>
+ * property of each one had been set individually.
+ *
+ * Any recognizer already attached to a different view is detached from it
+ * first. This is more efficient than setting <view> in a loop when attaching
+ * many recognizers at once, such as while populating the cells of a list.
+ *
+ * @param recognizers The event recognizers to attach.
+ * @param view The view to attach the recognizers to. This must not be `nil`.
+ */
++ (void)attachEventRecognizers:(NSArray *)recognizers toView:(id<VELBridgedView>)view;
+
 /**
  * The view that the receiver is attached to.
  *
@@ -266,6 +279,10 @@ NSString *NSStringFromVELEventRecognizerState(VELEventRecognizerState state);
  * words, the receiver cannot succeed if any one of the specified recognizers
  * succeed first.
  *
+ * Dependencies must not form a cycle (for example, two recognizers which
+ * each require the other to fail). Setting a value which would create a cycle
+ * is an error.
+ *
  * The default value for this property is an empty set. If set to `nil`, an
  * empty set is used instead, such that this property will never be `nil`.
  */
@@ -353,7 +370,8 @@ NSString *NSStringFromVELEventRecognizerState(VELEventRecognizerState state);
  * to recognize its event. If the event is successfully recognized, the
  * `NSEvent` objects are never delivered to the view. If the event fails to be
  * recognized, then the `NSEvent` objects are re-dispatched in the order they
- * arrived, using `-[NSApplication sendEvent:]`.
+ * arrived, directly to the views that would originally have received them.
+ * Other event recognizers do not see the re-dispatched events again.
  *
  * The default value for this property is `NO`.
  */
@@ -388,4 +406,23 @@ NSString *NSStringFromVELEventRecognizerState(VELEventRecognizerState state);
  */
 - (void)removeAllActions;
 
+/**
+ * Whether consecutive transitions to `VELEventRecognizerStateChanged` should
+ * be coalesced into a single invocation of the receiver's actions.
+ *
+ * If set to `YES`, the action blocks for a `VELEventRecognizerStateChanged`
+ * transition are not invoked immediately, but at most once per iteration of
+ * the main run loop, after all pending input for that iteration has been
+ * processed. The receiver will reflect the latest event (such as the most
+ * recent cursor location) at that point. Any pending update is always
+ * delivered before the actions for a subsequent transition (like
+ * `VELEventRecognizerStateEnded`).
+ *
+ * This is useful for continuous recognizers whose actions perform expensive
+ * work, and which would otherwise run once for every input event.
+ *
+ * The default value for this property is `NO`.
+ */
+@property (nonatomic, assign) BOOL coalescesChangedActions;
+
 @end
@@ -9,6 +9,7 @@
 #import "VELEventRecognizer.h"
 #import "EXTScope.h"
 #import "VELBridgedView.h"
+#import "VELEventManager.h"
 #import "VELEventRecognizerPrivate.h"
 #import "VELEventRecognizerProtected.h"
 #import <objc/runtime.h>
@@ -19,28 +20,110 @@
 typedef void (^VELEventRecognizerActionBlock)(id);
 
 /**
- * An associated objects key used to attach an `NSArray` of event recognizers to
- * their <[VELEventRecognizer view]>.
+ * An associated objects key used to attach an `NSMutableArray` of event
+ * recognizers to their <[VELEventRecognizer view]>.
+ *
+ * This array is modified in place as recognizers are attached and detached.
  */
 static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizers";
 
+/**
+ * An associated objects key used to cache an immutable copy of the array
+ * associated with <VELAttachedEventRecognizersKey>.
+ *
+ * This snapshot is created lazily by <[VELEventRecognizer
+ * eventRecognizersForView:]>, and discarded whenever the attached recognizers
+ * change, so that repeated attachments do not each pay for a copy.
+ */
+static void * const VELAttachedEventRecognizersSnapshotKey = "VELAttachedEventRecognizersSnapshot";
+
+/**
+ * The view that <[VELEventRecognizer attachEventRecognizers:toView:]> is
+ * currently attaching recognizers to, if any.
+ *
+ * While this is set, <[VELEventRecognizer addEventRecognizer:forView:]> leaves
+ * the snapshot of this view's recognizers alone, so that it is only discarded
+ * once for the whole batch.
+ */
+static __unsafe_unretained id<VELBridgedView> VELEventRecognizerBatchAttachmentView = nil;
+
+/**
+ * The recognizers with a `VELEventRecognizerStateChanged` action pending from
+ * <[VELEventRecognizer enqueueChangedAction]>, in the order that they were
+ * enqueued.
+ *
+ * These are flushed by <VELEventRecognizerChangedActionObserver>.
+ */
+static NSMutableArray *VELEventRecognizerPendingChangedActions = nil;
+
+/**
+ * An observer on the main run loop which flushes
+ * <VELEventRecognizerPendingChangedActions> just before the run loop waits for
+ * more input, so that all of the input available in an iteration is coalesced.
+ *
+ * This is created the first time an action is enqueued, and never removed.
+ */
+static CFRunLoopObserverRef VELEventRecognizerChangedActionObserver = NULL;
+
+/**
+ * Invokes <[VELEventRecognizer flushChangedAction]> on every recognizer in
+ * <VELEventRecognizerPendingChangedActions>.
+ */
+static void changedActionObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info);
+
 @interface VELEventRecognizer () {
     struct {
         unsigned enabled:1;
         unsigned delaysEventDelivery:1;
         unsigned handlesEventsAfterDescendants:1;
+        unsigned coalescesChangedActions:1;
+        unsigned changedActionPending:1;
+        unsigned transitionPending:1;
     } m_flags;
-}
 
-@property (nonatomic, strong, readonly) NSMutableSet *eventsToIgnore;
+    /**
+     * If a state transition is waiting on <recognizersRequiredToFail>, this is
+     * the state that the receiver will move to once they have all failed.
+     *
+     * This is only meaningful if `m_flags.transitionPending` is set.
+     */
+    VELEventRecognizerState m_pendingState;
+
+    /**
+     * The number of <recognizersRequiredToFail> which have yet to fail before
+     * the pending transition to `m_pendingState` can occur.
+     */
+    NSUInteger m_outstandingDependencyCount;
+
+    /**
+     * Contains the recognizers which have a pending state transition waiting
+     * on the receiver to fail.
+     *
+     * Recognizers are added to this array when they begin waiting on the
+     * receiver, and removed as soon as the receiver resolves (by failing or
+     * succeeding), so that each recognizer is notified at most once. The
+     * pointers in this array are not retained -- a dependent recognizer will
+     * always remove itself before being deallocated.
+     *
+     * This is created once the receiver is first used as a dependency, and
+     * reused thereafter.
+     */
+    NSPointerArray *m_waitingDependents;
+}
 
 /**
- * Stores the blocks for actions registered with <addActionUsingBlock:>.
+ * Stores the blocks for actions registered with <addActionUsingBlock:>, in the
+ * order that they were added.
+ *
+ * A block registered multiple times will appear in this array once for each
+ * registration, so that the behavior of calling <addActionUsingBlock:> and/or
+ * <removeAction:> multiple times with the same block is well-defined.
  *
- * This is a counted set so that the behavior of calling <addActionUsingBlock:>
- * and/or <removeAction:> multiple times with the same block is well-defined.
+ * This array is never mutated in place. Adding or removing an action replaces
+ * it, so <sendAction> can safely enumerate it without making a copy, even if
+ * action blocks add or remove actions.
  */
-@property (nonatomic, strong, readonly) NSCountedSet *actions;
+@property (nonatomic, copy) NSArray *actions;
 
 /**
  * If <delaysEventDelivery> is set to `YES`, this will contain events were
@@ -51,6 +134,14 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
  */
 @property (nonatomic, strong) NSMutableArray *delayedEvents;
 
+/**
+ * Contains the view that each object in <delayedEvents> would have been
+ * dispatched to, at the same index, or `NSNull` if the target is unknown.
+ *
+ * This array will be `nil` if <delaysEventDelivery> is `NO`.
+ */
+@property (nonatomic, strong) NSMutableArray *delayedEventTargets;
+
 /**
  * Attaches the given event recognizer to the given view.
  *
@@ -93,11 +184,57 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
  */
 - (void)reallySetState:(VELEventRecognizerState)newState;
 
+/**
+ * Returns whether adding the given recognizers to <recognizersRequiredToFail>
+ * would create a dependency cycle involving the receiver.
+ *
+ * @param recognizers The recognizers which are about to become dependencies of
+ * the receiver.
+ */
+- (BOOL)wouldCreateDependencyCycleWithRecognizers:(NSSet *)recognizers;
+
+/**
+ * Abandons any state transition which is waiting on <recognizersRequiredToFail>,
+ * and removes the receiver from the waiting dependents of each one.
+ */
+- (void)cancelPendingTransition;
+
+/**
+ * Informs any recognizers waiting on the receiver (as one of their
+ * <recognizersRequiredToFail>) of the receiver's current <state>, if it
+ * represents a success or a failure.
+ */
+- (void)resolveWaitingDependents;
+
+/**
+ * Invoked when one of the receiver's <recognizersRequiredToFail> has resolved
+ * while the receiver was waiting on it.
+ *
+ * @param succeeded Whether the dependency recognized its event. If `NO`, the
+ * dependency failed.
+ */
+- (void)dependencyDidResolveBySucceeding:(BOOL)succeeded;
+
 /**
  * Invokes all of the receiver's <actions>.
  */
 - (void)sendAction;
 
+/**
+ * Schedules a call to <sendAction> for the receiver's current
+ * `VELEventRecognizerStateChanged` state, to be delivered by
+ * <flushChangedAction>.
+ *
+ * If such a call is already pending, this does nothing.
+ */
+- (void)enqueueChangedAction;
+
+/**
+ * Sends any `VELEventRecognizerStateChanged` action pending from
+ * <enqueueChangedAction>, if the receiver is still in that state.
+ */
+- (void)flushChangedAction;
+
 /**
  * Sends any <delayedEvents> the receiver has, and empties the array.
  */
@@ -112,7 +249,7 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
 @synthesize state = m_state;
 @synthesize recognizersRequiredToFail = m_recognizersRequiredToFail;
 @synthesize delayedEvents = m_delayedEvents;
-@synthesize eventsToIgnore = m_eventsToIgnore;
+@synthesize delayedEventTargets = m_delayedEventTargets;
 @synthesize actions = m_actions;
 @synthesize shouldPreventEventRecognizerBlock = m_shouldPreventEventRecognizerBlock;
 @synthesize shouldBePreventedByEventRecognizerBlock = m_shouldBePreventedByEventRecognizerBlock;
@@ -159,11 +296,14 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     m_flags.delaysEventDelivery = delays;
 
     if (delays) {
-        if (!self.delayedEvents)
+        if (!self.delayedEvents) {
             self.delayedEvents = [NSMutableArray array];
+            self.delayedEventTargets = [NSMutableArray array];
+        }
     } else {
         [self sendDelayedEvents];
         self.delayedEvents = nil;
+        self.delayedEventTargets = nil;
     }
 }
 
@@ -175,14 +315,43 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     m_flags.handlesEventsAfterDescendants = value;
 }
 
+- (BOOL)coalescesChangedActions {
+    return m_flags.coalescesChangedActions;
+}
+
+- (void)setCoalescesChangedActions:(BOOL)value {
+    m_flags.coalescesChangedActions = value;
+
+    if (!value)
+        [self flushChangedAction];
+}
+
 - (void)setRecognizersRequiredToFail:(NSSet *)recognizers {
     if (m_recognizersRequiredToFail == recognizers)
         return;
 
+    if ([self wouldCreateDependencyCycleWithRecognizers:recognizers]) {
+        NSAssert(NO, @"Setting recognizersRequiredToFail %@ on event recognizer %@ would create a dependency cycle", recognizers, self);
+
+        // if assertions are disabled, log and return
+        NSLog(@"*** Setting recognizersRequiredToFail %@ on event recognizer %@ would create a dependency cycle", recognizers, self);
+        return;
+    }
+
+    // any pending transition was waiting on the old dependencies
+    [self cancelPendingTransition];
+
     if (recognizers.count)
         m_recognizersRequiredToFail = [recognizers copy];
     else
         m_recognizersRequiredToFail = [NSSet set];
+
+    // create the storage that each dependency will use to track us, so that
+    // nothing needs to be allocated during event handling
+    for (VELEventRecognizer *dependency in m_recognizersRequiredToFail) {
+        if (!dependency->m_waitingDependents)
+            dependency->m_waitingDependents = [NSPointerArray pointerArrayWithOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality];
+    }
 }
 
 // this method should never short-circuit if already in the given state,
@@ -191,87 +360,34 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     if (!self.enabled)
         return;
 
-    __block NSUInteger dependenciesOutstanding = 0;
-    __weak VELEventRecognizer *weakSelf = self;
+    if (m_flags.transitionPending) {
+        // this transition is already waiting on our dependencies
+        if (state == m_pendingState)
+            return;
 
-    // if all dependencies have failed, actually executes the transition
-    __block BOOL (^transitionIfDependenciesFailed)(void) = [^{
-        if (dependenciesOutstanding) {
-            return NO;
-        } else {
-            [weakSelf reallySetState:state];
-            return YES;
-        }
-    } copy];
+        // otherwise, the new transition supersedes the pending one
+        [self cancelPendingTransition];
+    }
 
     // check the status of dependencies, and delay the transition (pending their
     // failure) if necessary
     if (m_state != state && [self isNewlyRecognizedState:state]) {
-        // removes all actions added in the loop below
-        __block void (^removeAddedActions)(void) = [^{} copy];
-
-        for (__weak VELEventRecognizer *dependency in self.recognizersRequiredToFail) {
+        for (VELEventRecognizer *dependency in self.recognizersRequiredToFail) {
             if (dependency.state == VELEventRecognizerStateFailed)
                 continue;
 
-            ++dependenciesOutstanding;
-
-            id action = [dependency addActionUsingBlock:^(VELEventRecognizer *dependency){
-                switch (dependency.state) {
-                    case VELEventRecognizerStateBegan:
-                    case VELEventRecognizerStateRecognized: {
-                        // the dependency succeeded, so we should fail
-                        removeAddedActions();
-
-                        // match the style of the state transition that was
-                        // requested (discrete or continuous)
-                        if (state == VELEventRecognizerStateRecognized)
-                            [weakSelf reallySetState:VELEventRecognizerStateFailed];
-                        else
-                            [weakSelf reallySetState:VELEventRecognizerStatePossible];
-
-                        break;
-                    }
-
-                    case VELEventRecognizerStatePossible:
-                    case VELEventRecognizerStateFailed: {
-                        // the dependency failed -- wait on the rest or
-                        // perform our transition
-                        --dependenciesOutstanding;
-                        transitionIfDependenciesFailed();
-
-                        break;
-                    }
-
-                    default:
-                        ;
-                }
-            }];
-
-            // compose this with other actions that will need to be removed
-            void (^originalRemoveAddedActions)(void) = removeAddedActions;
-
-            removeAddedActions = [^{
-                originalRemoveAddedActions();
-                [dependency removeAction:action];
-            } copy];
+            [dependency->m_waitingDependents addPointer:(__bridge void *)self];
+            ++m_outstandingDependencyCount;
         }
 
-        BOOL (^originalTransition)(void) = transitionIfDependenciesFailed;
-
-        // remove actions if/when we finally transition
-        transitionIfDependenciesFailed = [^{
-            if (originalTransition()) {
-                removeAddedActions();
-                return YES;
-            } else {
-                return NO;
-            }
-        } copy];
+        if (m_outstandingDependencyCount) {
+            m_pendingState = state;
+            m_flags.transitionPending = YES;
+            return;
+        }
     }
-    
-    // this will also work if there were no dependencies
-    transitionIfDependenciesFailed();
+
+    [self reallySetState:state];
 }
 
 - (void)setView:(id<VELBridgedView>)view {
@@ -290,14 +406,18 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     if (!self)
         return nil;
 
-    m_actions = [NSCountedSet set];
+    m_actions = [NSArray array];
     m_flags.enabled = YES;
-    m_eventsToIgnore = [NSMutableSet set];
     m_recognizersRequiredToFail = [NSSet set];
 
     return self;
 }
 
+- (void)dealloc {
+    // remove ourselves from the (unretained) waiting lists of our dependencies
+    [self cancelPendingTransition];
+}
+
 #pragma mark Attached Recognizers
 
 + (void)addEventRecognizer:(VELEventRecognizer *)recognizer forView:(id<VELBridgedView>)view; {
@@ -306,21 +426,63 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     if (!view)
         return;
 
-    NSArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
-    if (!existingRecognizers)
-        existingRecognizers = [NSArray array];
+    NSMutableArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
+    if (!existingRecognizers) {
+        existingRecognizers = [NSMutableArray array];
+        objc_setAssociatedObject(view, VELAttachedEventRecognizersKey, existingRecognizers, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
 
-    NSAssert(![existingRecognizers containsObject:recognizer], @"Recognizer %@ is already attached to view %@", recognizer, view);
+    NSAssert([existingRecognizers indexOfObjectIdenticalTo:recognizer] == NSNotFound, @"Recognizer %@ is already attached to view %@", recognizer, view);
     
-    NSArray *newRecognizers = [existingRecognizers arrayByAddingObject:recognizer];
-    objc_setAssociatedObject(view, VELAttachedEventRecognizersKey, newRecognizers, OBJC_ASSOCIATION_COPY_NONATOMIC);
+    [existingRecognizers addObject:recognizer];
+
+    if (view != VELEventRecognizerBatchAttachmentView)
+        objc_setAssociatedObject(view, VELAttachedEventRecognizersSnapshotKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
++ (void)attachEventRecognizers:(NSArray *)recognizers toView:(id<VELBridgedView>)view; {
+    NSParameterAssert(view != nil);
+
+    if (!recognizers.count)
+        return;
+
+    NSMutableArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
+    if (!existingRecognizers) {
+        existingRecognizers = [NSMutableArray arrayWithCapacity:recognizers.count];
+        objc_setAssociatedObject(view, VELAttachedEventRecognizersKey, existingRecognizers, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
+
+    id<VELBridgedView> previousBatchView = VELEventRecognizerBatchAttachmentView;
+    VELEventRecognizerBatchAttachmentView = view;
+
+    @onExit {
+        VELEventRecognizerBatchAttachmentView = previousBatchView;
+        objc_setAssociatedObject(view, VELAttachedEventRecognizersSnapshotKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    };
+
+    // go through the setter, so that observers of the view property are
+    // notified, and recognizers are detached from their previous views
+    for (VELEventRecognizer *recognizer in recognizers) {
+        recognizer.view = view;
+    }
 }
 
 + (NSArray *)eventRecognizersForView:(id<VELBridgedView>)view; {
     if (!view)
         return nil;
 
-    return objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
+    NSArray *snapshot = objc_getAssociatedObject(view, VELAttachedEventRecognizersSnapshotKey);
+    if (snapshot)
+        return snapshot;
+
+    NSMutableArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
+    if (!existingRecognizers)
+        return nil;
+
+    snapshot = [existingRecognizers copy];
+    objc_setAssociatedObject(view, VELAttachedEventRecognizersSnapshotKey, snapshot, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+
+    return snapshot;
 }
 
 + (void)removeEventRecognizer:(VELEventRecognizer *)recognizer forView:(id<VELBridgedView>)view; {
@@ -329,17 +491,16 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     if (!view)
         return;
 
-    NSArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
+    NSMutableArray *existingRecognizers = objc_getAssociatedObject(view, VELAttachedEventRecognizersKey);
     if (!existingRecognizers)
         return;
 
-    NSMutableArray *newRecognizers = [existingRecognizers mutableCopy];
-    [newRecognizers removeObjectIdenticalTo:recognizer];
-
-    if (newRecognizers.count == existingRecognizers.count)
+    NSUInteger index = [existingRecognizers indexOfObjectIdenticalTo:recognizer];
+    if (index == NSNotFound)
         return;
-    
-    objc_setAssociatedObject(view, VELAttachedEventRecognizersKey, newRecognizers, OBJC_ASSOCIATION_COPY_NONATOMIC);
+
+    [existingRecognizers removeObjectAtIndex:index];
+    objc_setAssociatedObject(view, VELAttachedEventRecognizersSnapshotKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
 #pragma mark Event Handling
@@ -356,21 +517,33 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     }
 
     [self.delayedEvents addObject:event];
+    [self.delayedEventTargets addObject:[NSNull null]];
     return YES;
 }
 
+- (void)setDelayedEventTarget:(id<VELBridgedView>)view forEvent:(NSEvent *)event; {
+    NSParameterAssert(event != nil);
+
+    if (!view || [self.delayedEvents lastObject] != event)
+        return;
+
+    [self.delayedEventTargets replaceObjectAtIndex:self.delayedEventTargets.count - 1 withObject:view];
+}
+
 - (void)sendDelayedEvents; {
     if (!self.delaysEventDelivery)
         return;
 
+    if (!self.delayedEvents.count)
+        return;
+
     NSArray *delayedEvents = [self.delayedEvents copy];
-    [self.delayedEvents removeAllObjects];
+    NSArray *delayedEventTargets = [self.delayedEventTargets copy];
 
-    [self.eventsToIgnore addObjectsFromArray:delayedEvents];
+    [self.delayedEvents removeAllObjects];
+    [self.delayedEventTargets removeAllObjects];
 
-    for (NSEvent *event in delayedEvents) {
-        [NSApp postEvent:event atStart:NO];
-    }
+    [[VELEventManager defaultManager] replayDelayedEvents:delayedEvents targets:delayedEventTargets];
 }
 
 #pragma mark Dependencies
@@ -395,6 +568,111 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
         return NO;
 }
 
+- (BOOL)wouldCreateDependencyCycleWithRecognizers:(NSSet *)recognizers; {
+    // walk the dependency graph reachable from the new dependencies, looking
+    // for the receiver
+    NSHashTable *visited = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    NSMutableArray *stack = [[recognizers allObjects] mutableCopy];
+
+    while (stack.count) {
+        VELEventRecognizer *dependency = [stack lastObject];
+        [stack removeLastObject];
+
+        if (dependency == self)
+            return YES;
+
+        if ([visited containsObject:dependency])
+            continue;
+
+        [visited addObject:dependency];
+        [stack addObjectsFromArray:[dependency.recognizersRequiredToFail allObjects]];
+    }
+
+    return NO;
+}
+
+- (void)cancelPendingTransition; {
+    if (!m_flags.transitionPending)
+        return;
+
+    for (VELEventRecognizer *dependency in m_recognizersRequiredToFail) {
+        NSPointerArray *waitingDependents = dependency->m_waitingDependents;
+
+        for (NSUInteger i = waitingDependents.count; i > 0; --i) {
+            if ([waitingDependents pointerAtIndex:i - 1] == (__bridge void *)self) {
+                [waitingDependents removePointerAtIndex:i - 1];
+                break;
+            }
+        }
+    }
+
+    m_outstandingDependencyCount = 0;
+    m_flags.transitionPending = NO;
+}
+
+- (void)resolveWaitingDependents; {
+    if (!m_waitingDependents.count)
+        return;
+
+    BOOL succeeded;
+
+    switch (self.state) {
+        case VELEventRecognizerStateBegan:
+        case VELEventRecognizerStateRecognized:
+            succeeded = YES;
+            break;
+
+        case VELEventRecognizerStatePossible:
+        case VELEventRecognizerStateFailed:
+            succeeded = NO;
+            break;
+
+        default:
+            // not a resolution
+            return;
+    }
+
+    // each dependent is removed before being notified, so that it won't hear
+    // from us again for the same transition
+    while (m_waitingDependents.count) {
+        NSUInteger lastIndex = m_waitingDependents.count - 1;
+
+        VELEventRecognizer *dependent = (__bridge id)[m_waitingDependents pointerAtIndex:lastIndex];
+        [m_waitingDependents removePointerAtIndex:lastIndex];
+
+        [dependent dependencyDidResolveBySucceeding:succeeded];
+    }
+}
+
+- (void)dependencyDidResolveBySucceeding:(BOOL)succeeded; {
+    if (!m_flags.transitionPending)
+        return;
+
+    VELEventRecognizerState pendingState = m_pendingState;
+
+    if (succeeded) {
+        // the dependency succeeded, so we should fail
+        [self cancelPendingTransition];
+
+        // match the style of the state transition that was requested
+        // (discrete or continuous)
+        if (pendingState == VELEventRecognizerStateRecognized)
+            [self reallySetState:VELEventRecognizerStateFailed];
+        else
+            [self reallySetState:VELEventRecognizerStatePossible];
+
+        return;
+    }
+
+    NSAssert(m_outstandingDependencyCount > 0, @"Event recognizer %@ has a pending transition without any outstanding dependencies", self);
+
+    // the dependency failed -- wait on the rest or perform our transition
+    if (--m_outstandingDependencyCount == 0) {
+        m_flags.transitionPending = NO;
+        [self reallySetState:pendingState];
+    }
+}
+
 #pragma mark States and Transitions
 
 - (void)didTransitionFromState:(VELEventRecognizerState)fromState; {
@@ -422,12 +700,17 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     VELEventRecognizerState oldState = self.state;
     VELEventRecognizerState newState = VELEventRecognizerStatePossible;
 
+    // any coalesced update is now obsolete
+    m_flags.changedActionPending = NO;
+
     [self willTransitionToState:newState];
     m_state = newState;
     [self didTransitionFromState:oldState];
 
-    if (self.enabled)
+    if (self.enabled) {
+        [self resolveWaitingDependents];
         [self sendAction];
+    }
 }
 
 - (void)willTransitionToState:(VELEventRecognizerState)toState; {
@@ -510,6 +793,7 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     if ([self isNewlyRecognizedState:newState]) {
         // clear out any delayed events without sending them
         [self.delayedEvents removeAllObjects];
+        [self.delayedEventTargets removeAllObjects];
     }
 
     switch (newState) {
@@ -532,12 +816,24 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
             ;
     }
 
+    if (newState != VELEventRecognizerStateChanged) {
+        // deliver any coalesced update before moving on, so that actions
+        // still see every state
+        [self flushChangedAction];
+    }
+
     [self willTransitionToState:newState];
     m_state = newState;
     [self didTransitionFromState:oldState];
 
-    if (self.enabled)
-        [self sendAction];
+    if (self.enabled) {
+        [self resolveWaitingDependents];
+
+        if (newState == VELEventRecognizerStateChanged && self.coalescesChangedActions)
+            [self enqueueChangedAction];
+        else
+            [self sendAction];
+    }
 }
 
 #pragma mark Actions
@@ -548,7 +844,7 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
     // use a copied version of the block as the opaque 'action' type that we'll
     // store and return
     id action = [block copy];
-    [self.actions addObject:action];
+    self.actions = [self.actions arrayByAddingObject:action];
 
     return action;
 }
@@ -556,28 +852,71 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
 - (void)removeAction:(id)action; {
     NSParameterAssert(action != nil);
 
-    [self.actions removeObject:action];
+    NSArray *actions = self.actions;
+
+    NSUInteger index = [actions indexOfObjectIdenticalTo:action];
+    if (index == NSNotFound)
+        return;
+
+    NSMutableArray *newActions = [actions mutableCopy];
+    [newActions removeObjectAtIndex:index];
+
+    self.actions = newActions;
 }
 
 - (void)removeAllActions; {
-    [self.actions removeAllObjects];
+    self.actions = [NSArray array];
 }
 
 - (void)sendAction; {
-    // make a copy, in case any action blocks remove themselves or add new
-    // actions
-    NSSet *actions = [self.actions copy];
-    
+    // hold onto the current array, in case any action blocks remove themselves
+    // or add new actions
+    NSArray *actions = self.actions;
+
+    // blocks registered multiple times appear once for each registration
     for (VELEventRecognizerActionBlock block in actions) {
-        NSUInteger count = [self.actions countForObject:block];
+        block(self);
+    }
+}
 
-        // invoke the block once for each time it's been registered
-        for (NSUInteger i = 0; i < count; ++i) {
-            block(self);
-        }
+- (void)enqueueChangedAction; {
+    if (m_flags.changedActionPending)
+        return;
+
+    m_flags.changedActionPending = YES;
+
+    if (!VELEventRecognizerPendingChangedActions)
+        VELEventRecognizerPendingChangedActions = [[NSMutableArray alloc] init];
+
+    [VELEventRecognizerPendingChangedActions addObject:self];
+
+    if (!VELEventRecognizerChangedActionObserver) {
+        // deliver the latest state once this run loop iteration has finished
+        // processing input -- the main dispatch queue is drained between
+        // input events, so it would rarely coalesce anything
+        VELEventRecognizerChangedActionObserver = CFRunLoopObserverCreate(
+            NULL,
+            kCFRunLoopBeforeWaiting,
+            YES,
+            0,
+            &changedActionObserverCallback,
+            NULL
+        );
+
+        CFRunLoopAddObserver(CFRunLoopGetMain(), VELEventRecognizerChangedActionObserver, kCFRunLoopCommonModes);
     }
 }
 
+- (void)flushChangedAction; {
+    if (!m_flags.changedActionPending)
+        return;
+
+    m_flags.changedActionPending = NO;
+
+    if (self.enabled && self.state == VELEventRecognizerStateChanged)
+        [self sendAction];
+}
+
 #pragma mark NSObject overrides
 
 - (NSString *)description {
@@ -586,6 +925,19 @@ static void * const VELAttachedEventRecognizersKey = "VELAttachedEventRecognizer
 
 @end
 
+static void changedActionObserverCallback (CFRunLoopObserverRef observer, CFRunLoopActivity activity, void *info) {
+    NSArray *recognizers = VELEventRecognizerPendingChangedActions;
+    if (!recognizers.count)
+        return;
+
+    // actions may enqueue more changes, which will wait for the next iteration
+    VELEventRecognizerPendingChangedActions = nil;
+
+    for (VELEventRecognizer *recognizer in recognizers) {
+        [recognizer flushChangedAction];
+    }
+}
+
 NSString *NSStringFromVELEventRecognizerState(VELEventRecognizerState state) {
     switch (state) {
         case VELEventRecognizerStatePossible: return @"Possible";
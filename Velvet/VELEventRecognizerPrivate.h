@@ -14,12 +14,16 @@
  */
 @interface VELEventRecognizer (Private)
 /**
- * Contains any events that the receiver should ignore.
+ * Records the view that `event` would have been dispatched to, had the receiver
+ * not delayed its delivery.
  *
- * This is filled in with delayed events by the event recognizer. When
- * <VELEventManager> sees any objects in this array come through, it avoids
- * dispatching them to the receiver, and will remove them from the set at that
- * point.
+ * This is invoked by <VELEventManager> after the receiver has handled and
+ * delayed `event`, so that it can later be replayed directly to `view`. If
+ * `event` is not the receiver's most recently delayed event, or `view` is
+ * `nil`, nothing happens.
+ *
+ * @param view The view that was going to receive `event`.
+ * @param event An event that the receiver has delayed.
  */
-@property (nonatomic, strong, readonly) NSMutableSet *eventsToIgnore;
+- (void)setDelayedEventTarget:(id<VELBridgedView>)view forEvent:(NSEvent *)event;
 @end
@@ -0,0 +1,79 @@
+//
+//  VELKeyframeAction.h
+//  Velvet
+//
+//  Created by agent on 19.10.26.
+//  Copyright (c) 2026 Bitswift. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+#import <QuartzCore/QuartzCore.h>
+
+/*
+ * A `CAAction` which animates a layer property along a precomputed progress
+ * curve, using a `CAKeyframeAnimation`.
+ *
+ * A progress curve is an array of `NSNumber` values describing how far along
+ * the animation is at each keyframe, where zero is the starting value of the
+ * property and one is its final value. Values outside of that range are
+ * allowed, and result in the property overshooting its starting or final
+ * value.
+ *
+ * Curves are independent of the property being animated, so a single curve
+ * can be shared by any number of actions. The keyframe values for each layer
+ * are computed once, when the action is run.
+ */
+@interface VELKeyframeAction : NSObject <CAAction>
+
+/*
+ * @name Initialization
+ */
+
+/*
+ * Initializes an action which animates from `fromValue` to whatever value the
+ * property has when the action is run, along the given progress curve.
+ *
+ * This is the designated initializer.
+ *
+ * @param fromValue The value that the property has before changing.
+ * @param progressValues The progress curve to animate along. This array
+ * must contain at least two values.
+ * @param keyTimes The time at which each value in `progressValues` should be
+ * reached, as a fraction of `duration`. If this is `nil`, the values are
+ * spaced evenly.
+ * @param duration The duration of the animation.
+ */
+- (id)initWithFromValue:(id)fromValue progressValues:(NSArray *)progressValues keyTimes:(NSArray *)keyTimes duration:(CFTimeInterval)duration;
+
+/*
+ * @name Observing Completion
+ */
+
+/*
+ * The delegate to set on the animation created when the receiver is run, or
+ * `nil` to not set a delegate.
+ *
+ * Like the delegate of a `CAAnimation`, this object is retained.
+ */
+@property (nonatomic, strong) id delegate;
+
+/*
+ * @name Progress Curves
+ */
+
+/*
+ * Returns the progress curve of a spring, with a mass of one, that is released
+ * at rest from zero and settles at one.
+ *
+ * The curve is sampled at the display refresh rate (60 Hz) over `duration`,
+ * and its last value is always exactly one. Curves are cached, so repeated
+ * calls with the same arguments return the same array.
+ *
+ * @param duration The duration over which to sample the spring's motion.
+ * @param damping The damping coefficient of the spring. Lower values
+ * oscillate more.
+ * @param stiffness The stiffness of the spring. Higher values move faster.
+ */
++ (NSArray *)springProgressValuesWithDuration:(CFTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness;
+
+@end
@@ -0,0 +1,324 @@
+//
+//  VELKeyframeAction.m
+//  Velvet
+//
+//  Created by agent on 19.10.26.
+//  Copyright (c) 2026 Bitswift. All rights reserved.
+//
+
+#import "VELKeyframeAction.h"
+
+/*
+ * The rate at which spring curves are sampled, in samples per second.
+ */
+static const CFTimeInterval VELKeyframeActionSpringSampleRate = 60;
+
+/*
+ * The maximum number of spring curves to keep in
+ * <VELKeyframeActionSpringCurveCache>.
+ */
+static const NSUInteger VELKeyframeActionSpringCurveCacheLimit = 128;
+
+/*
+ * Caches the curves returned from <[VELKeyframeAction
+ * springProgressValuesWithDuration:damping:stiffness:]>, keyed by a string
+ * describing the arguments.
+ */
+static NSCache *VELKeyframeActionSpringCurveCache = nil;
+
+/*
+ * Returns the displacement of a spring at time `t`, as described in <[VELKeyframeAction
+ * springProgressValuesWithDuration:damping:stiffness:]>.
+ */
+static double springProgressAtTime (double t, double damping, double stiffness) {
+    double naturalFrequency = sqrt(stiffness);
+    double dampingRatio = damping / (2 * naturalFrequency);
+
+    if (dampingRatio < 1) {
+        // underdamped: oscillates around the final value
+        double dampedFrequency = naturalFrequency * sqrt(1 - dampingRatio * dampingRatio);
+        double envelope = exp(-dampingRatio * naturalFrequency * t);
+
+        return 1 - envelope * (cos(dampedFrequency * t) + (dampingRatio * naturalFrequency / dampedFrequency) * sin(dampedFrequency * t));
+    } else if (dampingRatio == 1) {
+        // critically damped
+        return 1 - exp(-naturalFrequency * t) * (1 + naturalFrequency * t);
+    } else {
+        // overdamped: approaches the final value without overshooting
+        double root = naturalFrequency * sqrt(dampingRatio * dampingRatio - 1);
+        double r1 = -dampingRatio * naturalFrequency + root;
+        double r2 = -dampingRatio * naturalFrequency - root;
+
+        return 1 - (r2 * exp(r1 * t) - r1 * exp(r2 * t)) / (r2 - r1);
+    }
+}
+
+/*
+ * The components of a 2D affine transform, which can be interpolated
+ * independently without distorting the transform.
+ *
+ * The transform is equivalent to scaling and shearing, then rotating, then
+ * translating.
+ */
+typedef struct {
+    CGFloat scaleX;
+    CGFloat scaleY;
+    CGFloat shear;
+    CGFloat rotation;
+    CGFloat translationX;
+    CGFloat translationY;
+} VELKeyframeActionAffineComponents;
+
+/*
+ * Decomposes `transform` into `components`, returning `NO` if the transform
+ * collapses the X axis and cannot be decomposed.
+ */
+static BOOL decomposeAffineTransform (CGAffineTransform transform, VELKeyframeActionAffineComponents *components) {
+    CGFloat scaleX = sqrt(transform.a * transform.a + transform.b * transform.b);
+    if (scaleX == 0)
+        return NO;
+
+    components->scaleX = scaleX;
+    components->rotation = atan2(transform.b, transform.a);
+    components->shear = (transform.a * transform.c + transform.b * transform.d) / scaleX;
+    components->scaleY = (transform.a * transform.d - transform.b * transform.c) / scaleX;
+    components->translationX = transform.tx;
+    components->translationY = transform.ty;
+
+    return YES;
+}
+
+/*
+ * Returns the affine transform described by `components`.
+ */
+static CGAffineTransform affineTransformFromComponents (VELKeyframeActionAffineComponents components) {
+    CGFloat cosine = cos(components.rotation);
+    CGFloat sine = sin(components.rotation);
+
+    return CGAffineTransformMake(
+        components.scaleX * cosine,
+        components.scaleX * sine,
+        components.shear * cosine - components.scaleY * sine,
+        components.shear * sine + components.scaleY * cosine,
+        components.translationX,
+        components.translationY
+    );
+}
+
+/*
+ * Returns the value `progress` of the way from `fromValue` to `toValue`, or
+ * `nil` if the values cannot be interpolated.
+ */
+static id interpolatedValue (id fromValue, id toValue, double progress) {
+    if ([fromValue isKindOfClass:[NSNumber class]] && [toValue isKindOfClass:[NSNumber class]]) {
+        double from = [fromValue doubleValue];
+        double to = [toValue doubleValue];
+
+        return [NSNumber numberWithDouble:from + (to - from) * progress];
+    }
+
+    if (![fromValue isKindOfClass:[NSValue class]] || ![toValue isKindOfClass:[NSValue class]])
+        return nil;
+
+    const char *type = [fromValue objCType];
+    if (strcmp(type, [toValue objCType]) != 0)
+        return nil;
+
+    #define lerp(FROM, TO) \
+        ((FROM) + ((TO) - (FROM)) * progress)
+
+    if (strcmp(type, @encode(CGPoint)) == 0) {
+        CGPoint from = [fromValue pointValue];
+        CGPoint to = [toValue pointValue];
+
+        return [NSValue valueWithPoint:CGPointMake(lerp(from.x, to.x), lerp(from.y, to.y))];
+    } else if (strcmp(type, @encode(CGSize)) == 0) {
+        CGSize from = [fromValue sizeValue];
+        CGSize to = [toValue sizeValue];
+
+        return [NSValue valueWithSize:CGSizeMake(lerp(from.width, to.width), lerp(from.height, to.height))];
+    } else if (strcmp(type, @encode(CGRect)) == 0) {
+        CGRect from = [fromValue rectValue];
+        CGRect to = [toValue rectValue];
+
+        return [NSValue valueWithRect:CGRectMake(
+            lerp(from.origin.x, to.origin.x),
+            lerp(from.origin.y, to.origin.y),
+            lerp(from.size.width, to.size.width),
+            lerp(from.size.height, to.size.height)
+        )];
+    } else if (strcmp(type, @encode(CATransform3D)) == 0) {
+        CATransform3D from = [fromValue CATransform3DValue];
+        CATransform3D to = [toValue CATransform3DValue];
+
+        // make sure that the curve starts and ends exactly on the original
+        // transforms, without any rounding error from decomposing them
+        if (progress == 0)
+            return fromValue;
+        else if (progress == 1)
+            return toValue;
+
+        // 3D transforms are left to Core Animation
+        if (!CATransform3DIsAffine(from) || !CATransform3DIsAffine(to))
+            return nil;
+
+        VELKeyframeActionAffineComponents fromComponents, toComponents;
+        if (!decomposeAffineTransform(CATransform3DGetAffineTransform(from), &fromComponents) || !decomposeAffineTransform(CATransform3DGetAffineTransform(to), &toComponents))
+            return nil;
+
+        // rotate the shortest way around
+        CGFloat rotationDelta = toComponents.rotation - fromComponents.rotation;
+        if (rotationDelta > M_PI)
+            toComponents.rotation -= 2 * M_PI;
+        else if (rotationDelta < -M_PI)
+            toComponents.rotation += 2 * M_PI;
+
+        VELKeyframeActionAffineComponents components = {
+            .scaleX = lerp(fromComponents.scaleX, toComponents.scaleX),
+            .scaleY = lerp(fromComponents.scaleY, toComponents.scaleY),
+            .shear = lerp(fromComponents.shear, toComponents.shear),
+            .rotation = lerp(fromComponents.rotation, toComponents.rotation),
+            .translationX = lerp(fromComponents.translationX, toComponents.translationX),
+            .translationY = lerp(fromComponents.translationY, toComponents.translationY)
+        };
+
+        return [NSValue valueWithCATransform3D:CATransform3DMakeAffineTransform(affineTransformFromComponents(components))];
+    }
+
+    #undef lerp
+
+    return nil;
+}
+
+@interface VELKeyframeAction ()
+/*
+ * The value of the property before it changed.
+ */
+@property (nonatomic, strong, readonly) id fromValue;
+
+/*
+ * The progress curve to animate along.
+ */
+@property (nonatomic, copy, readonly) NSArray *progressValues;
+
+/*
+ * The time of each value in <progressValues>, or `nil` to space them evenly.
+ */
+@property (nonatomic, copy, readonly) NSArray *keyTimes;
+
+/*
+ * The duration of the animation.
+ */
+@property (nonatomic, assign, readonly) CFTimeInterval duration;
+@end
+
+@implementation VELKeyframeAction
+
+#pragma mark Properties
+
+@synthesize fromValue = m_fromValue;
+@synthesize progressValues = m_progressValues;
+@synthesize keyTimes = m_keyTimes;
+@synthesize duration = m_duration;
+@synthesize delegate = m_delegate;
+
+#pragma mark Lifecycle
+
++ (void)initialize {
+    if (self != [VELKeyframeAction class])
+        return;
+
+    VELKeyframeActionSpringCurveCache = [[NSCache alloc] init];
+    VELKeyframeActionSpringCurveCache.name = @"com.bitswift.Velvet.VELKeyframeActionSpringCurveCache";
+    VELKeyframeActionSpringCurveCache.countLimit = VELKeyframeActionSpringCurveCacheLimit;
+}
+
+- (id)initWithFromValue:(id)fromValue progressValues:(NSArray *)progressValues keyTimes:(NSArray *)keyTimes duration:(CFTimeInterval)duration; {
+    NSParameterAssert([progressValues count] >= 2);
+    NSParameterAssert(!keyTimes || [keyTimes count] == [progressValues count]);
+
+    self = [super init];
+    if (!self)
+        return nil;
+
+    m_fromValue = fromValue;
+    m_progressValues = [progressValues copy];
+    m_keyTimes = [keyTimes copy];
+    m_duration = duration;
+    return self;
+}
+
+#pragma mark Progress Curves
+
++ (NSArray *)springProgressValuesWithDuration:(CFTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness; {
+    NSParameterAssert(duration >= 0);
+    NSParameterAssert(damping >= 0);
+    NSParameterAssert(stiffness > 0);
+
+    // use hexadecimal floating-point, so that the key is exact
+    NSString *key = [NSString stringWithFormat:@"%a %a %a", (double)duration, (double)damping, (double)stiffness];
+
+    NSArray *curve = [VELKeyframeActionSpringCurveCache objectForKey:key];
+    if (curve)
+        return curve;
+
+    NSUInteger sampleCount = MAX(2, (NSUInteger)ceil(duration * VELKeyframeActionSpringSampleRate) + 1);
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:sampleCount];
+
+    for (NSUInteger i = 0; i < sampleCount - 1; ++i) {
+        double t = duration * i / (sampleCount - 1);
+        [values addObject:[NSNumber numberWithDouble:springProgressAtTime(t, damping, stiffness)]];
+    }
+
+    // always end up exactly at the final value
+    [values addObject:[NSNumber numberWithDouble:1]];
+
+    curve = [values copy];
+    [VELKeyframeActionSpringCurveCache setObject:curve forKey:key];
+
+    return curve;
+}
+
+#pragma mark CAAction
+
+- (void)runActionForKey:(NSString *)key object:(id)anObject arguments:(NSDictionary *)dict {
+    CALayer *layer = anObject;
+    id toValue = [layer valueForKey:key];
+
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:[self.progressValues count]];
+
+    for (NSNumber *progress in self.progressValues) {
+        id value = interpolatedValue(self.fromValue, toValue, [progress doubleValue]);
+        if (!value) {
+            values = nil;
+            break;
+        }
+
+        [values addObject:value];
+    }
+
+    CAAnimation *animation;
+
+    if (values) {
+        CAKeyframeAnimation *keyframeAnimation = [CAKeyframeAnimation animationWithKeyPath:key];
+        keyframeAnimation.values = values;
+        keyframeAnimation.keyTimes = self.keyTimes;
+        keyframeAnimation.calculationMode = kCAAnimationLinear;
+
+        animation = keyframeAnimation;
+    } else {
+        // this property can't be interpolated by us (e.g., it's a color or
+        // a 3D transform), so just animate it linearly
+        CABasicAnimation *basicAnimation = [CABasicAnimation animationWithKeyPath:key];
+        basicAnimation.fromValue = self.fromValue;
+        basicAnimation.toValue = toValue;
+
+        animation = basicAnimation;
+    }
+
+    animation.duration = self.duration;
+    animation.delegate = self.delegate;
+    [layer addAnimation:animation forKey:key];
+}
+
+@end
@@ -14,8 +14,143 @@
 #import "NSVelvetView.h"
 #import "NSVelvetViewPrivate.h"
 #import "NSView+VELBridgedViewAdditions.h"
+#import "VELAnimationManager.h"
 #import "VELNSViewPrivate.h"
+#import "VELViewPrivate.h"
 #import "EXTScope.h"
+#import <objc/runtime.h>
+#import <pthread.h>
+
+/*
+ * The maximum number of bytes of `NSView` snapshots to keep in
+ * <VELNSViewSnapshotCache>.
+ */
+static const NSUInteger VELNSViewSnapshotCacheCostLimit = 64 * 1024 * 1024;
+
+/*
+ * Caches the rendering of `NSView`s for animation, keyed by a nonretained
+ * `NSValue` of each `NSView`.
+ *
+ * Each <VELNSView> remembers the content generation that its snapshot was
+ * rendered at, and ignores the cached snapshot if its content has changed
+ * since.
+ *
+ * `NSCache` automatically evicts snapshots when the system is under memory
+ * pressure.
+ */
+static NSCache *VELNSViewSnapshotCache = nil;
+
+/*
+ * The number of snapshots currently in <VELNSViewSnapshotCache>.
+ *
+ * If this is zero, there's no need to track content changes for any `NSView`.
+ */
+static NSUInteger VELNSViewSnapshotCount = 0;
+
+/*
+ * Contains every `NSView` in the hierarchy of a <VELNSView> guest view, by
+ * pointer. The views are not retained.
+ *
+ * This lets the methods swizzled below ignore views outside of any guest
+ * hierarchy with a single lookup, instead of walking up their superviews. It
+ * is kept up-to-date by <[VELNSView setGuestView:]> and by the swizzled
+ * `-didAddSubview:` and `-willRemoveSubview:`.
+ *
+ * This should only be used from the main thread.
+ */
+static CFMutableSetRef VELNSViewGuestHierarchyViews = NULL;
+
+/*
+ * Adds the given view and all of its descendants to
+ * <VELNSViewGuestHierarchyViews>, or removes them from it.
+ */
+static void setViewInGuestHierarchy (NSView *view, BOOL inGuestHierarchy);
+
+/*
+ * Returns whether the given view is in <VELNSViewGuestHierarchyViews>.
+ */
+static BOOL viewIsInGuestHierarchy (NSView *view);
+
+/*
+ * Marks the content of any <VELNSView> hosting the given view as having
+ * changed.
+ *
+ * This does nothing off the main thread, or if there are no snapshots in
+ * <VELNSViewSnapshotCache>.
+ */
+static void invalidateSnapshotContainingView (NSView *view);
+
+/*
+ * Finds the `NSView` backing the given layer, or its nearest ancestor layer
+ * with a delegate, and invokes invalidateSnapshotContainingView() with it.
+ *
+ * This does nothing off the main thread, or if there are no snapshots in
+ * <VELNSViewSnapshotCache>.
+ */
+static void invalidateSnapshotContainingLayer (CALayer *layer);
+
+/*
+ * The original implementation of `-[NSView setNeedsDisplayInRect:]`.
+ */
+static void (*originalSetNeedsDisplayInRectIMP)(id, SEL, NSRect);
+
+/*
+ * Marks the content of any <VELNSView> hosting the given view as having
+ * changed, then invokes <originalSetNeedsDisplayInRectIMP>.
+ */
+static void setNeedsDisplayInRectInvalidatingSnapshot (NSView *self, SEL _cmd, NSRect rect);
+
+/*
+ * The original implementations of the `NSView` geometry and visibility setters
+ * that can change the rendering of a hosted view.
+ */
+static void (*originalSetFrameOriginIMP)(id, SEL, NSPoint);
+static void (*originalSetFrameSizeIMP)(id, SEL, NSSize);
+static void (*originalSetHiddenIMP)(id, SEL, BOOL);
+static void (*originalSetAlphaValueIMP)(id, SEL, CGFloat);
+
+/*
+ * Invoke the corresponding original implementation, marking the content of any
+ * <VELNSView> hosting the view as having changed if the value actually
+ * changed.
+ *
+ * The frame origin of a <VELNSView> guest view doesn't affect its snapshot, so
+ * origin changes only invalidate the snapshot of a view's superview.
+ */
+static void setFrameOriginInvalidatingSnapshot (NSView *self, SEL _cmd, NSPoint origin);
+static void setFrameSizeInvalidatingSnapshot (NSView *self, SEL _cmd, NSSize size);
+static void setHiddenInvalidatingSnapshot (NSView *self, SEL _cmd, BOOL hidden);
+static void setAlphaValueInvalidatingSnapshot (NSView *self, SEL _cmd, CGFloat alpha);
+
+/*
+ * The original implementations of the `NSView` subview notifications.
+ */
+static void (*originalDidAddSubviewIMP)(id, SEL, NSView *);
+static void (*originalWillRemoveSubviewIMP)(id, SEL, NSView *);
+
+/*
+ * Mark the content of any <VELNSView> hosting the view as having changed,
+ * update <VELNSViewGuestHierarchyViews> for the subview, then invoke the
+ * corresponding original implementation.
+ */
+static void didAddSubviewInvalidatingSnapshot (NSView *self, SEL _cmd, NSView *subview);
+static void willRemoveSubviewInvalidatingSnapshot (NSView *self, SEL _cmd, NSView *subview);
+
+/*
+ * The original implementations of the `CALayer` methods used to update the
+ * content of a layer-backed view directly.
+ */
+static void (*originalLayerSetNeedsDisplayIMP)(id, SEL);
+static void (*originalLayerSetNeedsDisplayInRectIMP)(id, SEL, CGRect);
+static void (*originalLayerSetContentsIMP)(id, SEL, id);
+
+/*
+ * Mark the content of any <VELNSView> hosting the layer as having changed,
+ * then invoke the corresponding original implementation.
+ */
+static void layerSetNeedsDisplayInvalidatingSnapshot (CALayer *self, SEL _cmd);
+static void layerSetNeedsDisplayInRectInvalidatingSnapshot (CALayer *self, SEL _cmd, CGRect rect);
+static void layerSetContentsInvalidatingSnapshot (CALayer *self, SEL _cmd, id contents);
 
 @interface VELNSView () {
     /**
@@ -24,6 +159,24 @@
      */
     NSUInteger m_renderingContainedViewCount;
 
+    /**
+     * The value of <[VELView hierarchyGeneration]> when <treeOrderKey> was last
+     * computed.
+     */
+    NSUInteger m_treeOrderKeyGeneration;
+
+    /**
+     * A counter incremented whenever the rendering of the <guestView> may have
+     * changed.
+     */
+    NSUInteger m_contentGeneration;
+
+    /**
+     * The value of `m_contentGeneration` when the snapshot in
+     * <VELNSViewSnapshotCache> was rendered.
+     */
+    NSUInteger m_snapshotGeneration;
+
     #ifdef DEBUG
     /**
      * An observer for `VELHostViewDebugModeChangedNotification`.
@@ -35,6 +188,21 @@
 - (void)synchronizeNSViewGeometry;
 - (void)startRenderingContainedView;
 - (void)stopRenderingContainedView;
+
+/**
+ * Invalidates any cached snapshot of the <guestView>.
+ */
+- (void)guestViewContentDidChange;
+
+/**
+ * Returns a rendering of the <guestView> suitable for use as the contents of
+ * the receiver's layer, reusing a cached snapshot if the `NSView` hasn't
+ * changed since it was rendered.
+ */
+- (CGImageRef)snapshotOfGuestView;
+
+@property (nonatomic, assign) CGRect clippedBoundsInNSVelvetView;
+@property (nonatomic, assign) NSUInteger clippingGeneration;
 @end
 
 @implementation VELNSView
@@ -42,6 +210,32 @@
 #pragma mark Properties
 
 @synthesize guestView = m_guestView;
+@synthesize clippedBoundsInNSVelvetView = m_clippedBoundsInNSVelvetView;
+@synthesize clippingGeneration = m_clippingGeneration;
+@synthesize treeOrderKey = m_treeOrderKey;
+
+- (NSIndexPath *)treeOrderKey {
+    NSUInteger generation = [VELView hierarchyGeneration];
+    if (m_treeOrderKey && m_treeOrderKeyGeneration == generation)
+        return m_treeOrderKey;
+
+    NSUInteger depth = 0;
+    for (VELView *view = self; view.superview; view = view.superview) {
+        ++depth;
+    }
+
+    NSUInteger indexes[depth ?: 1];
+    NSUInteger position = depth;
+
+    for (VELView *view = self; position > 0; view = view.superview) {
+        indexes[--position] = [view.superview.subviews indexOfObjectIdenticalTo:view];
+    }
+
+    m_treeOrderKey = [NSIndexPath indexPathWithIndexes:indexes length:depth];
+    m_treeOrderKeyGeneration = generation;
+
+    return m_treeOrderKey;
+}
 
 - (void)setFocused:(BOOL)focused {
     [super setFocused:focused];
@@ -55,6 +249,12 @@
     // remove any existing guest view
     [m_guestView removeFromSuperview];
     m_guestView.hostView = nil;
+    setViewInGuestHierarchy(m_guestView, NO);
+
+    if (m_guestView)
+        [VELNSViewSnapshotCache removeObjectForKey:[NSValue valueWithNonretainedObject:m_guestView]];
+
+    [self guestViewContentDidChange];
 
     m_guestView = view;
 
@@ -68,8 +268,9 @@
 
         [velvetView.appKitHostView addSubview:m_guestView];
         m_guestView.hostView = self;
+        setViewInGuestHierarchy(m_guestView, YES);
 
-        [velvetView recalculateNSViewOrdering];
+        [velvetView recalculateNSViewOrderingForHostView:self];
 
         m_guestView.nextResponder = self;
         [self synchronizeNSViewGeometry];
@@ -105,6 +306,16 @@
 
 #pragma mark Lifecycle
 
++ (void)initialize {
+    if (self != [VELNSView class])
+        return;
+
+    VELNSViewSnapshotCache = [[NSCache alloc] init];
+    VELNSViewSnapshotCache.name = @"com.bitswift.Velvet.VELNSViewSnapshotCache";
+    VELNSViewSnapshotCache.totalCostLimit = VELNSViewSnapshotCacheCostLimit;
+    VELNSViewSnapshotCache.delegate = (id)self;
+}
+
 - (id)init {
     self = [super init];
     if (!self)
@@ -138,7 +349,11 @@
     }
     #endif
 
+    if (m_guestView)
+        [VELNSViewSnapshotCache removeObjectForKey:[NSValue valueWithNonretainedObject:m_guestView]];
+
     self.guestView.hostView = nil;
+    setViewInGuestHierarchy(self.guestView, NO);
 }
 
 #pragma mark Geometry
@@ -154,6 +369,9 @@
     NSAssert(self.ancestorNSVelvetView, @"%@ should be in an NSVelvetView if it has a window", self);
 
     CGRect frame = self.NSViewFrame;
+    if (!CGSizeEqualToSize(frame.size, self.guestView.frame.size))
+        [self guestViewContentDidChange];
+
     self.guestView.frame = frame;
 
     [self.ancestorNSVelvetView recalculateNSViewClipping];
@@ -170,12 +388,21 @@
     [self.guestView.layer renderInContext:context];
 }
 
+- (void)setNeedsDisplay {
+    [super setNeedsDisplay];
+    [self guestViewContentDidChange];
+}
+
+- (void)setNeedsDisplayInRect:(CGRect)rect {
+    [super setNeedsDisplayInRect:rect];
+    [self guestViewContentDidChange];
+}
+
 - (void)startRenderingContainedView; {
     if (m_renderingContainedViewCount++ == 0) {
         [CATransaction performWithDisabledActions:^{
             [self synchronizeNSViewGeometry];
-            [self.guestView displayIfNeeded];
-            [self.layer display];
+            self.layer.contents = (__bridge id)[self snapshotOfGuestView];
         }];
     }
 }
@@ -188,6 +415,95 @@
     }
 }
 
+#pragma mark Snapshots
+
+- (void)guestViewContentDidChange; {
+    ++m_contentGeneration;
+}
+
+- (void)prepareSnapshotOfGuestView; {
+    if (!self.window)
+        return;
+
+    [CATransaction performWithDisabledActions:^{
+        [self synchronizeNSViewGeometry];
+        [self snapshotOfGuestView];
+    }];
+}
+
+- (CGImageRef)snapshotOfGuestView; {
+    NSView *guestView = self.guestView;
+    if (!guestView)
+        return NULL;
+
+    CGSize size = self.bounds.size;
+    CGFloat scale = self.layer.contentsScale;
+
+    size.width = ceil(size.width * scale);
+    size.height = ceil(size.height * scale);
+
+    if (size.width <= 0 || size.height <= 0)
+        return NULL;
+
+    NSValue *key = [NSValue valueWithNonretainedObject:guestView];
+
+    if (m_snapshotGeneration == m_contentGeneration) {
+        CGImageRef snapshot = (__bridge CGImageRef)[VELNSViewSnapshotCache objectForKey:key];
+
+        // the content generation doesn't track changes in scale factor, so
+        // make sure the snapshot is still the right size
+        if (snapshot && CGImageGetWidth(snapshot) == size.width && CGImageGetHeight(snapshot) == size.height)
+            return snapshot;
+    }
+
+    [guestView displayIfNeeded];
+
+    CGContextRef context = CGBitmapContextCreateGeneric(size, YES);
+    if (!context)
+        return NULL;
+
+    @onExit {
+        CGContextRelease(context);
+    };
+
+    // scale the context to the pixel density
+    CGContextScaleCTM(context, scale, scale);
+
+    [guestView.layer renderInContext:context];
+
+    CGImageRef snapshot = CGBitmapContextCreateImage(context);
+    if (!snapshot)
+        return NULL;
+
+    __autoreleasing id autoreleasedSnapshot = (__bridge_transfer id)snapshot;
+
+    // remove any existing snapshot first, so that VELNSViewSnapshotCount stays
+    // balanced
+    [VELNSViewSnapshotCache removeObjectForKey:key];
+
+    // NSCache may evict objects (including this one) from within
+    // -setObject:forKey:cost:, so count the snapshot before inserting it
+    ++VELNSViewSnapshotCount;
+    [VELNSViewSnapshotCache setObject:autoreleasedSnapshot forKey:key cost:CGImageGetBytesPerRow(snapshot) * CGImageGetHeight(snapshot)];
+
+    [[VELAnimationManager defaultManager] recordTelemetryForSnapshot];
+
+    // rendering may have marked the NSView as needing display, but the
+    // snapshot is up-to-date at this point
+    m_snapshotGeneration = m_contentGeneration;
+
+    return snapshot;
+}
+
+#pragma mark NSCacheDelegate
+
++ (void)cache:(NSCache *)cache willEvictObject:(id)obj {
+    // the count only serves to skip invalidation work, so never let it wrap
+    // around if an eviction happens to go unbalanced
+    if (VELNSViewSnapshotCount > 0)
+        --VELNSViewSnapshotCount;
+}
+
 #pragma mark View hierarchy
 
 - (void)ancestorDidLayout; {
@@ -244,7 +560,7 @@
     }];
     #endif
 
-    [self.ancestorNSVelvetView recalculateNSViewOrdering];
+    [self.ancestorNSVelvetView recalculateNSViewOrderingForHostView:self];
     [self synchronizeNSViewGeometry];
 }
 
@@ -297,3 +613,176 @@
 }
 
 @end
+
+static void setViewInGuestHierarchy (NSView *view, BOOL inGuestHierarchy) {
+    if (!view)
+        return;
+
+    if (!VELNSViewGuestHierarchyViews) {
+        if (!inGuestHierarchy)
+            return;
+
+        VELNSViewGuestHierarchyViews = CFSetCreateMutable(NULL, 0, NULL);
+    }
+
+    if (inGuestHierarchy)
+        CFSetAddValue(VELNSViewGuestHierarchyViews, (__bridge void *)view);
+    else
+        CFSetRemoveValue(VELNSViewGuestHierarchyViews, (__bridge void *)view);
+
+    for (NSView *subview in view.subviews) {
+        setViewInGuestHierarchy(subview, inGuestHierarchy);
+    }
+}
+
+static BOOL viewIsInGuestHierarchy (NSView *view) {
+    if (!VELNSViewGuestHierarchyViews)
+        return NO;
+
+    return CFSetContainsValue(VELNSViewGuestHierarchyViews, (__bridge void *)view);
+}
+
+static void invalidateSnapshotContainingView (NSView *view) {
+    // content generations are only read and written on the main thread, and
+    // there's nothing to do unless a snapshot could need invalidating
+    if (!pthread_main_np() || !VELNSViewSnapshotCount)
+        return;
+
+    // only walk up the superviews of views that are actually hosted
+    if (!viewIsInGuestHierarchy(view))
+        return;
+
+    id hostView = view.hostView;
+    if ([hostView isKindOfClass:[VELNSView class]])
+        [hostView guestViewContentDidChange];
+}
+
+static void invalidateSnapshotContainingLayer (CALayer *layer) {
+    if (!pthread_main_np() || !VELNSViewSnapshotCount)
+        return;
+
+    // find the nearest layer with a delegate, which is usually the layer
+    // itself, and only invalidate if it's backing an NSView (e.g., not
+    // a VELView)
+    while (layer) {
+        id delegate = layer.delegate;
+
+        if (delegate) {
+            if ([delegate isKindOfClass:[NSView class]])
+                invalidateSnapshotContainingView(delegate);
+
+            return;
+        }
+
+        layer = layer.superlayer;
+    }
+}
+
+static void setNeedsDisplayInRectInvalidatingSnapshot (NSView *self, SEL _cmd, NSRect rect) {
+    originalSetNeedsDisplayInRectIMP(self, _cmd, rect);
+    invalidateSnapshotContainingView(self);
+}
+
+static void setFrameOriginInvalidatingSnapshot (NSView *self, SEL _cmd, NSPoint origin) {
+    BOOL changed = !NSEqualPoints(self.frame.origin, origin);
+    originalSetFrameOriginIMP(self, _cmd, origin);
+
+    NSView *superview = self.superview;
+    if (changed && superview)
+        invalidateSnapshotContainingView(superview);
+}
+
+static void setFrameSizeInvalidatingSnapshot (NSView *self, SEL _cmd, NSSize size) {
+    BOOL changed = !NSEqualSizes(self.frame.size, size);
+    originalSetFrameSizeIMP(self, _cmd, size);
+
+    if (changed)
+        invalidateSnapshotContainingView(self);
+}
+
+static void setHiddenInvalidatingSnapshot (NSView *self, SEL _cmd, BOOL hidden) {
+    BOOL changed = ([self isHidden] != hidden);
+    originalSetHiddenIMP(self, _cmd, hidden);
+
+    if (changed)
+        invalidateSnapshotContainingView(self);
+}
+
+static void setAlphaValueInvalidatingSnapshot (NSView *self, SEL _cmd, CGFloat alpha) {
+    BOOL changed = (self.alphaValue != alpha);
+    originalSetAlphaValueIMP(self, _cmd, alpha);
+
+    if (changed)
+        invalidateSnapshotContainingView(self);
+}
+
+static void didAddSubviewInvalidatingSnapshot (NSView *self, SEL _cmd, NSView *subview) {
+    if (pthread_main_np() && viewIsInGuestHierarchy(self)) {
+        setViewInGuestHierarchy(subview, YES);
+        invalidateSnapshotContainingView(self);
+    }
+
+    originalDidAddSubviewIMP(self, _cmd, subview);
+}
+
+static void willRemoveSubviewInvalidatingSnapshot (NSView *self, SEL _cmd, NSView *subview) {
+    if (pthread_main_np() && viewIsInGuestHierarchy(self)) {
+        setViewInGuestHierarchy(subview, NO);
+        invalidateSnapshotContainingView(self);
+    }
+
+    originalWillRemoveSubviewIMP(self, _cmd, subview);
+}
+
+static void layerSetNeedsDisplayInvalidatingSnapshot (CALayer *self, SEL _cmd) {
+    invalidateSnapshotContainingLayer(self);
+    originalLayerSetNeedsDisplayIMP(self, _cmd);
+}
+
+static void layerSetNeedsDisplayInRectInvalidatingSnapshot (CALayer *self, SEL _cmd, CGRect rect) {
+    invalidateSnapshotContainingLayer(self);
+    originalLayerSetNeedsDisplayInRectIMP(self, _cmd, rect);
+}
+
+static void layerSetContentsInvalidatingSnapshot (CALayer *self, SEL _cmd, id contents) {
+    invalidateSnapshotContainingLayer(self);
+    originalLayerSetContentsIMP(self, _cmd, contents);
+}
+
+/*
+ * Replaces the implementation of the given selector on the given class with
+ * the given function, returning the original implementation.
+ */
+static IMP replaceMethodWithFunction (Class cls, SEL selector, IMP function) {
+    Method method = class_getInstanceMethod(cls, selector);
+    IMP originalIMP = method_getImplementation(method);
+
+    class_replaceMethod(cls, method_getName(method), function, method_getTypeEncoding(method));
+    return originalIMP;
+}
+
+@implementation NSView (UnsafeVELNSViewSnapshotAdditions)
+
++ (void)load {
+    originalSetNeedsDisplayInRectIMP = (void (*)(id, SEL, NSRect))replaceMethodWithFunction(self, @selector(setNeedsDisplayInRect:), (IMP)&setNeedsDisplayInRectInvalidatingSnapshot);
+
+    originalSetFrameOriginIMP = (void (*)(id, SEL, NSPoint))replaceMethodWithFunction(self, @selector(setFrameOrigin:), (IMP)&setFrameOriginInvalidatingSnapshot);
+    originalSetFrameSizeIMP = (void (*)(id, SEL, NSSize))replaceMethodWithFunction(self, @selector(setFrameSize:), (IMP)&setFrameSizeInvalidatingSnapshot);
+    originalSetHiddenIMP = (void (*)(id, SEL, BOOL))replaceMethodWithFunction(self, @selector(setHidden:), (IMP)&setHiddenInvalidatingSnapshot);
+    originalSetAlphaValueIMP = (void (*)(id, SEL, CGFloat))replaceMethodWithFunction(self, @selector(setAlphaValue:), (IMP)&setAlphaValueInvalidatingSnapshot);
+
+    originalDidAddSubviewIMP = (void (*)(id, SEL, NSView *))replaceMethodWithFunction(self, @selector(didAddSubview:), (IMP)&didAddSubviewInvalidatingSnapshot);
+    originalWillRemoveSubviewIMP = (void (*)(id, SEL, NSView *))replaceMethodWithFunction(self, @selector(willRemoveSubview:), (IMP)&willRemoveSubviewInvalidatingSnapshot);
+}
+
+@end
+
+@implementation CALayer (UnsafeVELNSViewSnapshotAdditions)
+
++ (void)load {
+    originalLayerSetNeedsDisplayIMP = (void (*)(id, SEL))replaceMethodWithFunction(self, @selector(setNeedsDisplay), (IMP)&layerSetNeedsDisplayInvalidatingSnapshot);
+    originalLayerSetNeedsDisplayInRectIMP = (void (*)(id, SEL, CGRect))replaceMethodWithFunction(self, @selector(setNeedsDisplayInRect:), (IMP)&layerSetNeedsDisplayInRectInvalidatingSnapshot);
+    originalLayerSetContentsIMP = (void (*)(id, SEL, id))replaceMethodWithFunction(self, @selector(setContents:), (IMP)&layerSetContentsInvalidatingSnapshot);
+}
+
+@end
@@ -39,6 +39,16 @@
  */
 - (void)stopRenderingContainedView;
 
+/**
+ * Renders a snapshot of the receiver's <guestView> and caches it, so that a
+ * later call to <startRenderingContainedView> can use it without rendering
+ * again.
+ *
+ * This does nothing if the receiver is not in a window, or if an up-to-date
+ * snapshot already exists.
+ */
+- (void)prepareSnapshotOfGuestView;
+
 /**
  * The frame that the receiver's `NSView` should have at the time of call.
  *
@@ -54,4 +64,31 @@
  * the receiver, ensuring that the `NSView` is laid out correctly on screen.
  */
 - (void)synchronizeNSViewGeometry;
+
+/**
+ * The visible bounds of the receiver, clipped by its ancestors and converted
+ * into the coordinate system of its <[VELBridgedView ancestorNSVelvetView]>,
+ * as of the last call to <[NSVelvetView recalculateNSViewClipping]>.
+ *
+ * This will be `CGRectNull` if the receiver was entirely clipped. The value is
+ * only meaningful if <clippingGeneration> matches the current generation of the
+ * `NSVelvetView`.
+ */
+@property (nonatomic, assign) CGRect clippedBoundsInNSVelvetView;
+
+/**
+ * The generation of the <[NSVelvetView recalculateNSViewClipping]> pass which
+ * set <clippedBoundsInNSVelvetView>, or zero if it has never been set.
+ */
+@property (nonatomic, assign) NSUInteger clippingGeneration;
+
+/**
+ * The path of subview indices leading from the root of the receiver's Velvet
+ * hierarchy down to the receiver.
+ *
+ * Comparing the keys of two views in the same hierarchy gives their relative
+ * order when rendered, from back to front. The key is cached, and only
+ * recomputed after the Velvet hierarchy has changed.
+ */
+@property (nonatomic, copy, readonly) NSIndexPath *treeOrderKey;
 @end
@@ -802,6 +802,199 @@ typedef enum {
  */
 + (void)animateWithDuration:(NSTimeInterval)duration options:(VELViewAnimationOptions)options animations:(void (^)(void))animations completion:(void (^)(void))completionBlock;
 
+/**
+ * Animates changes to one or more views using a spring.
+ *
+ * The motion of the spring is sampled ahead of time into keyframes, which are
+ * shared by every animation using the same parameters, so animating many
+ * views this way requires no additional work while the animation runs.
+ *
+ * @param duration The length of the animation. The spring should come to rest
+ * within this time, or it will jump to its final value at the end.
+ * @param damping The damping coefficient of the spring. Lower values cause the
+ * spring to oscillate more around its final value.
+ * @param stiffness The stiffness of the spring. Higher values cause the spring
+ * to move more quickly.
+ * @param animations A block containing the changes to make that should be
+ * animated.
+ */
++ (void)animateWithDuration:(NSTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness animations:(void (^)(void))animations;
+
+/**
+ * Animates changes to one or more views using a spring.
+ *
+ * See <animateWithDuration:damping:stiffness:animations:> for more
+ * information.
+ *
+ * @param duration The length of the animation.
+ * @param damping The damping coefficient of the spring.
+ * @param stiffness The stiffness of the spring.
+ * @param animations A block containing the changes to make that should be
+ * animated.
+ * @param completionBlock A block to execute when the effect of the animation
+ * completes.
+ */
++ (void)animateWithDuration:(NSTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness animations:(void (^)(void))animations completion:(void (^)(void))completionBlock;
+
+/**
+ * Animates changes to one or more views through a sequence of keyframes.
+ *
+ * Each keyframe is described by a progress value, indicating how far each
+ * property should be from its original value (zero) to its new value (one).
+ * Progress values may be outside of that range, to overshoot or anticipate the
+ * change.
+ *
+ * Affine transforms are decomposed into their scale, rotation and translation,
+ * which are each moved along the keyframes. Properties which cannot be
+ * interpolated (such as colors and 3D transforms) are animated linearly
+ * instead.
+ *
+ * @param duration The length of the animation.
+ * @param keyTimes An array of `NSNumber` objects, between zero and one, that
+ * specify when each keyframe should be reached, as a fraction of `duration`.
+ * If this is `nil`, the keyframes are spaced evenly.
+ * @param progressValues An array of `NSNumber` objects describing each
+ * keyframe, as explained above. This must contain at least two values, and
+ * the same number of values as `keyTimes`, if it is not `nil`.
+ * @param animations A block containing the changes to make that should be
+ * animated.
+ * @param completionBlock A block to execute when the effect of the animation
+ * completes.
+ */
++ (void)animateWithDuration:(NSTimeInterval)duration keyTimes:(NSArray *)keyTimes progressValues:(NSArray *)progressValues animations:(void (^)(void))animations completion:(void (^)(void))completionBlock;
+
+/**
+ * Prepares the receiver and its descendants to be animated, by rendering any
+ * hosted `NSView`s ahead of time.
+ *
+ * Animations involving a <VELNSView> need a static rendering of its `NSView`.
+ * Normally, this is done synchronously when the animation begins, which can
+ * cause the first frame to stutter if many `NSView`s are involved. This method
+ * instead renders them a few at a time whenever the main run loop is idle.
+ *
+ * Renderings remain valid until the `NSView` is redisplayed or resized.
+ *
+ * @param completionBlock A block to invoke on the main thread once all
+ * renderings are ready. This may be `nil`.
+ */
+- (void)prepareForAnimationWithCompletion:(void (^)(void))completionBlock;
+
+/**
+ * Animates a numeric property of the receiver that is not backed by its layer,
+ * such as a value that affects what is drawn in <drawRect:>.
+ *
+ * The property must be key-value coding compliant, and accept `NSNumber`
+ * values. It will be set once per display refresh for the duration of the
+ * animation, on the main thread. Intermediate values are computed on
+ * a background thread, and all views animating custom properties are updated
+ * together in a single callback per frame.
+ *
+ * Starting a new animation of the same property stops any animation already in
+ * progress. If the animation cannot be run at all (for instance, because there
+ * is no active display), the property is set to its final value immediately,
+ * and the completion block is invoked with `NO`.
+ *
+ * @param key The key of the property to animate.
+ * @param value The final value for the property.
+ * @param duration The duration of the animation.
+ * @param options Options controlling the animation. Only the animation curve
+ * is used.
+ * @param completionBlock A block to execute when the animation completes. The
+ * argument to the block will be `NO` if the animation was stopped before
+ * reaching its final value. This may be `nil`.
+ */
+- (void)animateValueForKey:(NSString *)key toValue:(double)value duration:(NSTimeInterval)duration options:(VELViewAnimationOptions)options completion:(void (^)(BOOL finished))completionBlock;
+
+/**
+ * Stops any animation of the given custom property, started with
+ * <animateValueForKey:toValue:duration:options:completion:>, leaving the
+ * property at its current value.
+ *
+ * @param key The key of the property to stop animating, or `nil` to stop all
+ * custom property animations of the receiver.
+ */
+- (void)stopAnimatingValueForKey:(NSString *)key;
+
+/**
+ * Whether animation blocks should be merged into the current Core Animation
+ * transaction, instead of flushing pending changes before each one.
+ *
+ * By default, every animation block begins by flushing all pending layer
+ * changes to the render server. This guarantees that animations start from the
+ * latest committed state, but is expensive when many small animations are
+ * started within a single run loop iteration.
+ *
+ * If this is set to `YES`, nested and sibling animation blocks within the same
+ * run loop iteration are committed together with the enclosing transaction.
+ * To keep animations starting from the right state, the starting value,
+ * duration and timing function of each layer animation are captured at the
+ * time the property is changed.
+ *
+ * The default value is `NO`.
+ */
++ (BOOL)mergesAnimationTransactions;
+
+/**
+ * Sets whether animation blocks should be merged into the current Core
+ * Animation transaction.
+ *
+ * @param merges Whether to merge animation transactions. See
+ * <mergesAnimationTransactions> for more information.
+ */
++ (void)setMergesAnimationTransactions:(BOOL)merges;
+
+/**
+ * Whether statistics are being recorded about animations.
+ *
+ * While this is enabled, every animation block records how long its
+ * animations took to define, how many layers it touched, and how many
+ * <VELNSView> snapshots were rendered for it. In addition, the interval
+ * between frames is recorded for as long as any recorded animation is in
+ * progress.
+ *
+ * The default value is `NO`.
+ */
++ (BOOL)recordsAnimationTelemetry;
+
+/**
+ * Sets whether statistics should be recorded about animations.
+ *
+ * Recorded data is kept until <resetAnimationTelemetry> is invoked, even after
+ * recording is disabled.
+ *
+ * @param records Whether to record statistics. See
+ * <recordsAnimationTelemetry> for more information.
+ */
++ (void)setRecordsAnimationTelemetry:(BOOL)records;
+
+/**
+ * Returns all of the animation statistics recorded so far.
+ *
+ * The returned dictionary contains two arrays:
+ *
+ *  - `animationBlocks`, which contains a dictionary for each animation block,
+ *  in the order that they finished. Each dictionary contains the
+ *  `beginTime` of the block, in seconds since recording started, its
+ *  `defineDuration` in seconds, its `nestingLevel` (zero for an outermost
+ *  block), and its `layerCount` and `snapshotCount`.
+ *  - `frameIntervals`, which contains the time between each pair of
+ *  consecutive frames displayed during animations, in seconds.
+ *
+ * The returned dictionary can be serialized with `NSJSONSerialization`.
+ */
++ (NSDictionary *)animationTelemetry;
+
+/**
+ * Returns <animationTelemetry> serialized as JSON, suitable for writing to
+ * a file.
+ */
++ (NSData *)animationTelemetryJSONData;
+
+/**
+ * Discards all of the animation statistics recorded so far.
+ */
++ (void)resetAnimationTelemetry;
+
 /**
  * @name Core Animation Layer
  */
@@ -18,9 +18,12 @@
 #import "NSVelvetView.h"
 #import "NSVelvetViewPrivate.h"
 #import "NSView+VELBridgedViewAdditions.h"
+#import "VELAnimationManager.h"
 #import "VELCAAction.h"
+#import "VELCustomPropertyAnimation.h"
 #import "VELDraggingDestination.h"
 #import "VELHostView.h"
+#import "VELKeyframeAction.h"
 #import "VELNSViewPrivate.h"
 #import "VELScrollView.h"
 #import "VELViewController.h"
@@ -41,16 +44,115 @@ static NSUInteger VELViewCurrentAnimationBlockDepth = 0;
  */
 static VELViewAnimationOptions VELViewCurrentAnimationOptions = 0;
 
+/*
+ * Whether the current animation block is being recorded by <[VELAnimationManager
+ * beginTelemetryForAnimationBlock]>.
+ *
+ * This lets <actionForLayer:forKey:> skip messaging the animation manager
+ * entirely when telemetry is not being recorded.
+ */
+static BOOL VELViewCurrentAnimationRecordsTelemetry = NO;
+
 /*
  * Keeps track of any layers that need to be laid out before the current
- * animation block is committed.
+ * animation blocks are committed.
+ *
+ * Each animation block which lays out views appends to the end of this list,
+ * and removes its layers again after laying them out, so the same array is
+ * reused across all animation blocks. The layers should be marked as needing
+ * layout before being added to this list.
+ */
+static NSMutableArray *VELViewCurrentAnimationLayersNeedingLayout = nil;
+
+/*
+ * Identifies the current animation block for the purposes of
+ * <VELViewCurrentAnimationLayersNeedingLayout>, or zero if layers should not
+ * be added to the list.
+ *
+ * A layer has already been added by the current animation block if it has been
+ * stamped with this generation.
+ */
+static NSUInteger VELViewCurrentAnimationLayoutGeneration = 0;
+
+/*
+ * The last value assigned to <VELViewCurrentAnimationLayoutGeneration>. This
+ * is used to allocate unique generations.
+ */
+static NSUInteger VELViewLastAnimationLayoutGeneration = 0;
+
+/*
+ * A key for associating a layout generation stamp with layers that do not
+ * belong to a <VELView>.
+ */
+static char VELViewLayoutGenerationKey;
+
+/*
+ * Whether animation blocks are merged into the current transaction, instead of
+ * flushing it first.
+ *
+ * See <[VELView mergesAnimationTransactions]>.
+ */
+static BOOL VELViewMergesAnimationTransactions = NO;
+
+/*
+ * The progress curve that animations in the current animation block should
+ * follow, or `nil` to use a normal `CABasicAnimation`.
+ *
+ * See <[VELView animateWithDuration:keyTimes:progressValues:animations:completion:]>.
+ */
+static NSArray *VELViewCurrentAnimationProgressValues = nil;
+
+/*
+ * The key times for <VELViewCurrentAnimationProgressValues>, or `nil` if the
+ * values are spaced evenly.
+ */
+static NSArray *VELViewCurrentAnimationKeyTimes = nil;
+
+/*
+ * Returns the value that an animation of `key` on `layer` should start from.
  *
- * The layers should be marked as needing layout before being added to this set.
+ * This is normally the layer's current value for `key` -- unless the property
+ * is already animating, in which case it's wherever the property is on screen.
+ */
+static id VELViewStartingValueForKey (CALayer *layer, NSString *key) {
+    CALayer *sourceLayer = layer;
+    if ([layer animationForKey:key] && [layer presentationLayer])
+        sourceLayer = [layer presentationLayer];
+
+    return [sourceLayer valueForKey:key];
+}
+
+/*
+ * Returns an action which captures the current state of `layer`, and the
+ * current transaction's animation parameters, so that the animation will
+ * behave the same regardless of when the enclosing transaction is committed.
+ *
+ * If `action` is not a `CABasicAnimation`, it is returned unmodified.
  *
- * This should always be set to `nil` after all animations are committed, to
- * make sure the array is properly released.
+ * @param action The action that would otherwise be run for `key`.
+ * @param layer The layer whose property is about to change.
+ * @param key The key of the property that is about to change.
  */
-static NSMutableSet *VELViewCurrentAnimationLayersNeedingLayout = nil;
+static id<CAAction> VELViewActionCapturingAnimationState (id<CAAction> action, CALayer *layer, NSString *key) {
+    if (![(id)action isKindOfClass:[CABasicAnimation class]])
+        return action;
+
+    CABasicAnimation *animation = [(id)action copy];
+
+    if (!animation.fromValue && !animation.byValue) {
+        // without a flush, the render server may not have seen the layer's
+        // latest value yet, so don't rely on it to find the starting point
+        animation.fromValue = VELViewStartingValueForKey(layer, key);
+    }
+
+    if (animation.duration <= 0)
+        animation.duration = [CATransaction animationDuration];
+
+    if (!animation.timingFunction)
+        animation.timingFunction = [CATransaction animationTimingFunction];
+
+    return animation;
+}
 
 /*
  * The function pointer to <VELView>'s implementation of <drawRect:>.
@@ -69,6 +171,29 @@ static IMP VELViewDrawRectIMP = NULL;
  */
 static BOOL VELViewPerformingDeepLayout = NO;
 
+/*
+ * Incremented every time the `nextResponder` of any <VELView> or
+ * <VELViewController> changes.
+ */
+static NSUInteger VELViewResponderChainGeneration = 0;
+
+/*
+ * Incremented every time the <[VELView subviews]> of any view are inserted,
+ * removed, or reordered, and every time the <[VELView superview]> of any view
+ * changes.
+ */
+static NSUInteger VELViewHierarchyGeneration = 0;
+
+/*
+ * Whether <[VELView viewHierarchyDidChange]> is being propagated through
+ * a subtree containing more than one <VELNSView>.
+ *
+ * While this is `YES`, the `NSView`s in the subtree can't be repositioned one
+ * at a time, since each would be compared against the others before they've
+ * moved. The root of the subtree re-sorts all of them at the end instead.
+ */
+static BOOL VELViewRepositioningHostedNSViewsInBulk = NO;
+
 /**
  * A mask for the <VELViewAnimationOptions> that specify animation curves.
  */
@@ -79,6 +204,33 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     VELViewAnimationOptionCurveLinear
 ;
 
+/*
+ * Returns the timing function for the animation curve specified in `options`,
+ * or `nil` if no curve is specified.
+ */
+static CAMediaTimingFunction *VELViewTimingFunctionForAnimationOptions (VELViewAnimationOptions options) {
+    switch (options & VELViewAnimationOptionCurveMask) {
+        case VELViewAnimationOptionCurveEaseInEaseOut:
+            return [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut];
+
+        case VELViewAnimationOptionCurveEaseIn:
+            return [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseIn];
+
+        case VELViewAnimationOptionCurveEaseOut:
+            return [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseOut];
+
+        case VELViewAnimationOptionCurveLinear:
+            return [CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear];
+
+        case 0:
+            return nil;
+
+        default:
+            NSCAssert(NO, @"Unrecognized animation curve in VELViewAnimationOptions %i", (int)options);
+            return nil;
+    }
+}
+
 @interface VELView () {
     struct {
         unsigned userInteractionEnabled:1;
@@ -98,6 +250,32 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
      * specific interface methods for doing so.
      */
     NSMutableArray *m_subviews;
+
+    /*
+     * The number of superviews above the receiver, as of the
+     * <VELViewHierarchyGeneration> saved in `m_depthGeneration`.
+     */
+    NSUInteger m_depth;
+
+    /*
+     * The value of <VELViewHierarchyGeneration> when `m_depth` was computed,
+     * plus one (so that zero means it has never been computed).
+     */
+    NSUInteger m_depthGeneration;
+
+    /*
+     * The number of <VELNSView> instances in the subtree rooted at the
+     * receiver, including the receiver itself.
+     *
+     * This is updated whenever the <superview> of a view changes.
+     */
+    NSUInteger m_hostedNSViewCount;
+
+    /*
+     * The value of <VELViewCurrentAnimationLayoutGeneration> when the receiver's
+     * layer was last added to <VELViewCurrentAnimationLayersNeedingLayout>.
+     */
+    NSUInteger m_layoutGeneration;
 }
 
 @property (nonatomic, readwrite, weak) VELView *superview;
@@ -152,6 +330,17 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
  */
 + (BOOL)isDefiningAnimation;
 
+/**
+ * Marks `layer` as needing layout, and adds it to
+ * <VELViewCurrentAnimationLayersNeedingLayout>, if it hasn't been already in
+ * the current animation block.
+ *
+ * @param layer The layer to lay out.
+ * @param owner The <VELView> whose layer is `layer`, or `nil` if `layer`
+ * doesn't belong to a view.
+ */
++ (void)setNeedsLayoutForAnimationOfLayer:(CALayer *)layer owner:(VELView *)owner;
+
 /**
  * Invokes the given block with the receiver and all of its <subviews>,
  * recursively.
@@ -177,6 +366,12 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
  */
 - (void)updateViewAndViewControllerNextResponders;
 
+/**
+ * The number of superviews above the receiver. This is cached until the view
+ * hierarchy changes.
+ */
+@property (nonatomic, readonly) NSUInteger depth;
+
 @end
 
 @implementation VELView
@@ -403,6 +598,7 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     [self willChangeValueForKey:@"subviews"];
 
     @onExit {
+        ++VELViewHierarchyGeneration;
         [self didChangeValueForKey:@"subviews"];
         self.replacingSubviews = NO;
     };
@@ -412,6 +608,7 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 
         if ([newSubviews count]) {
             m_subviews = [[NSMutableArray alloc] initWithCapacity:[newSubviews count]];
+            ++VELViewHierarchyGeneration;
 
             // preserve any subviews we already had, but order them to match the input
             [newSubviews enumerateObjectsUsingBlock:^(VELView *view, NSUInteger newIndex, BOOL *stop){
@@ -425,6 +622,7 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 
                     [oldSubviews removeObjectAtIndex:existingIndex];
                     [m_subviews addObject:view];
+                    ++VELViewHierarchyGeneration;
 
                     [view viewHierarchyDidChange];
                 }
@@ -666,6 +864,9 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     m_layer = [[[self class] layerClass] layer];
     m_layer.delegate = self;
 
+    if ([self isKindOfClass:[VELNSView class]])
+        m_hostedNSViewCount = 1;
+
     self.userInteractionEnabled = YES;
 
     // prefer safer defaults over performant defaults -- disregarding safety (or
@@ -685,6 +886,30 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     return self;
 }
 
+- (void)setSuperview:(VELView *)superview {
+    VELView *oldSuperview = m_superview;
+    if (superview == oldSuperview)
+        return;
+
+    if (m_hostedNSViewCount) {
+        for (VELView *view = oldSuperview; view; view = view.superview) {
+            NSAssert(view->m_hostedNSViewCount >= m_hostedNSViewCount, @"%@ should be counting at least %lu VELNSViews", view, (unsigned long)m_hostedNSViewCount);
+            view->m_hostedNSViewCount -= m_hostedNSViewCount;
+        }
+
+        for (VELView *view = superview; view; view = view.superview) {
+            view->m_hostedNSViewCount += m_hostedNSViewCount;
+        }
+    }
+
+    m_superview = superview;
+
+    // bump this here, rather than relying on callers, so that cached depths
+    // are never read in between a view being removed from its superview's
+    // subviews and its superview being cleared
+    ++VELViewHierarchyGeneration;
+}
+
 - (id)initWithFrame:(CGRect)frame; {
     self = [self init];
     if (!self)
@@ -712,6 +937,9 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
         else if (view.viewController.nextResponder == self)
             view.viewController.nextResponder = nil;
     }
+
+    // anything caching unretained responders must not outlive us
+    [VELView responderChainDidChange];
 }
 
 #pragma mark Rendering
@@ -790,6 +1018,7 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 
     void (^insertSubviewAndSublayer)(void) = ^{
         [m_subviews insertObject:view atIndex:index];
+        ++VELViewHierarchyGeneration;
 
         if (index > 0)
             [self.layer insertSublayer:view.layer above:[[m_subviews objectAtIndex:index - 1] layer]];
@@ -804,6 +1033,7 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
         // Remove the previous instance of view from m_subviews after we've reinserted it.
         currentObjectIndex = index > currentObjectIndex ? currentObjectIndex : currentObjectIndex + 1;
         [m_subviews removeObjectAtIndex:currentObjectIndex];
+        ++VELViewHierarchyGeneration;
         return;
     }
 
@@ -856,7 +1086,46 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     }];
 }
 
+- (NSUInteger)depth {
+    if (m_depthGeneration != VELViewHierarchyGeneration + 1) {
+        VELView *superview = self.superview;
+
+        m_depth = superview ? superview.depth + 1 : 0;
+        m_depthGeneration = VELViewHierarchyGeneration + 1;
+    }
+
+    return m_depth;
+}
+
 - (VELView *)ancestorSharedWithView:(VELView *)view; {
+    if (!view)
+        return nil;
+
+    // bring both views to the same depth, then walk them up in lockstep until
+    // they meet
+    VELView *viewA = self;
+    VELView *viewB = view;
+
+    NSUInteger depthA = viewA.depth;
+    NSUInteger depthB = viewB.depth;
+
+    for (; depthA > depthB; --depthA)
+        viewA = viewA.superview;
+
+    for (; depthB > depthA; --depthB)
+        viewB = viewB.superview;
+
+    while (viewA != viewB) {
+        viewA = viewA.superview;
+        viewB = viewB.superview;
+    }
+
+    if (viewA)
+        return viewA;
+
+    // the views don't share a Velvet root, but 'view' may still be hosted
+    // somewhere inside our hierarchy (across an NSView boundary), so fall back
+    // to searching the long way
     VELView *parentView = self;
 
     do {
@@ -940,6 +1209,15 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     };
 
     [m_subviews removeObjectAtIndex:index];
+    ++VELViewHierarchyGeneration;
+}
+
++ (NSUInteger)hierarchyGeneration; {
+    return VELViewHierarchyGeneration;
+}
+
++ (BOOL)isRepositioningHostedNSViewsInBulk; {
+    return VELViewRepositioningHostedNSViewsInBulk;
 }
 
 - (void)didMoveFromSuperview:(VELView *)superview; {
@@ -979,15 +1257,41 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
         }
     }
 
+    BOOL repositionsInBulk = (!VELViewRepositioningHostedNSViewsInBulk && m_hostedNSViewCount > 1);
+    if (!repositionsInBulk) {
+        [self.subviews makeObjectsPerformSelector:_cmd];
+        return;
+    }
+
+    VELViewRepositioningHostedNSViewsInBulk = YES;
+    @onExit {
+        VELViewRepositioningHostedNSViewsInBulk = NO;
+    };
+
     [self.subviews makeObjectsPerformSelector:_cmd];
+
+    [self.ancestorNSVelvetView recalculateNSViewOrdering];
 }
 
 #pragma mark Responder chain
 
++ (NSUInteger)responderChainGeneration; {
+    return VELViewResponderChainGeneration;
+}
+
++ (void)responderChainDidChange; {
+    ++VELViewResponderChainGeneration;
+}
+
 - (BOOL)acceptsFirstResponder {
     return YES;
 }
 
+- (void)setNextResponder:(NSResponder *)responder {
+    [super setNextResponder:responder];
+    [VELView responderChainDidChange];
+}
+
 - (void)updateViewAndViewControllerNextResponders; {
     NSResponder *responderAfterViewController;
 
@@ -1225,21 +1529,53 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     
     NSAssert([NSThread isMainThread], @"Animations should only be enqueued on the main thread");
 
-    [CATransaction flush];
+    if (!VELViewMergesAnimationTransactions)
+        [CATransaction flush];
+
+    VELAnimationManager *animationManager = [VELAnimationManager defaultManager];
+
+    // only pay for telemetry if it's being recorded
+    BOOL recordsTelemetry = [animationManager beginTelemetryForAnimationBlock];
+    if (recordsTelemetry) {
+        void (^originalCompletionBlock)(void) = completionBlock;
+
+        completionBlock = ^{
+            [animationManager animationBlockForTelemetryDidComplete];
+
+            if (originalCompletionBlock)
+                originalCompletionBlock();
+        };
+    }
 
     VELViewAnimationOptions lastAnimationOptions = VELViewCurrentAnimationOptions;
-    NSMutableSet *lastLayersNeedingLayout = VELViewCurrentAnimationLayersNeedingLayout;
+    NSUInteger lastLayoutGeneration = VELViewCurrentAnimationLayoutGeneration;
+    NSArray *lastProgressValues = VELViewCurrentAnimationProgressValues;
+    NSArray *lastKeyTimes = VELViewCurrentAnimationKeyTimes;
+    BOOL lastRecordsTelemetry = VELViewCurrentAnimationRecordsTelemetry;
 
     @onExit {
         VELViewCurrentAnimationOptions = lastAnimationOptions;
-        VELViewCurrentAnimationLayersNeedingLayout = lastLayersNeedingLayout;
+        VELViewCurrentAnimationLayoutGeneration = lastLayoutGeneration;
+        VELViewCurrentAnimationProgressValues = lastProgressValues;
+        VELViewCurrentAnimationKeyTimes = lastKeyTimes;
+        VELViewCurrentAnimationRecordsTelemetry = lastRecordsTelemetry;
     };
 
+    VELViewCurrentAnimationRecordsTelemetry = recordsTelemetry;
+
     [CATransaction begin];
     @onExit {
         [CATransaction commit];
     };
 
+    // this will run before the transaction is committed, so that the record
+    // only covers defining the animations (committing a nested transaction
+    // would just merge it into the enclosing one anyways)
+    @onExit {
+        if (recordsTelemetry)
+            [animationManager endTelemetryForAnimationBlock];
+    };
+
     ++VELViewCurrentAnimationBlockDepth;
     @onExit {
         --VELViewCurrentAnimationBlockDepth;
@@ -1250,7 +1586,15 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 
     setupBlock();
 
-    [[NSAnimationContext currentContext] setDuration:[CATransaction animationDuration]];
+    NSAnimationContext *animationContext = [NSAnimationContext currentContext];
+    NSTimeInterval duration = [CATransaction animationDuration];
+
+    if (animationContext.duration != duration) {
+        animationContext.duration = duration;
+
+        // only pay for the reset on run loop iterations that actually need it
+        [animationManager animationContextDurationDidChange];
+    }
 
     animations();
 }
@@ -1262,7 +1606,9 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 + (void)animate:(void (^)(void))animations completion:(void (^)(void))completionBlock; {
     void (^setup)(void) = ^{
         VELViewCurrentAnimationOptions = 0;
-        VELViewCurrentAnimationLayersNeedingLayout = nil;
+        VELViewCurrentAnimationLayoutGeneration = 0;
+        VELViewCurrentAnimationProgressValues = nil;
+        VELViewCurrentAnimationKeyTimes = nil;
     };
 
     [self animateWithSetupBlock:setup animations:animations completion:completionBlock];
@@ -1283,47 +1629,66 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 + (void)animateWithDuration:(NSTimeInterval)duration options:(VELViewAnimationOptions)options animations:(void (^)(void))animations completion:(void (^)(void))completionBlock; {
     void (^setup)(void) = ^{
         VELViewCurrentAnimationOptions = options;
-        VELViewCurrentAnimationLayersNeedingLayout = [[NSMutableSet alloc] init];
+        VELViewCurrentAnimationLayoutGeneration = ++VELViewLastAnimationLayoutGeneration;
+        VELViewCurrentAnimationProgressValues = nil;
+        VELViewCurrentAnimationKeyTimes = nil;
+
+        if (!VELViewCurrentAnimationLayersNeedingLayout)
+            VELViewCurrentAnimationLayersNeedingLayout = [[NSMutableArray alloc] init];
 
         [CATransaction setAnimationDuration:duration];
 
-        switch (options & VELViewAnimationOptionCurveMask) {
-            case VELViewAnimationOptionCurveEaseInEaseOut:
-                [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseInEaseOut]];
-                break;
+        CAMediaTimingFunction *timingFunction = VELViewTimingFunctionForAnimationOptions(options);
+        if (timingFunction)
+            [CATransaction setAnimationTimingFunction:timingFunction];
+    };
+
+    void (^animationsPlusLayout)(void) = ^{
+        // any layers added from this index onward belong to this animation
+        // block
+        NSUInteger firstLayerIndex = [VELViewCurrentAnimationLayersNeedingLayout count];
 
-            case VELViewAnimationOptionCurveEaseIn:
-                [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseIn]];
-                break;
+        animations();
 
-            case VELViewAnimationOptionCurveEaseOut:
-                [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionEaseOut]];
-                break;
+        // don't allow any new layers to get marked as needing layout
+        VELViewCurrentAnimationLayoutGeneration = 0;
 
-            case VELViewAnimationOptionCurveLinear:
-                [CATransaction setAnimationTimingFunction:[CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear]];
-                break;
+        NSRange layersRange = NSMakeRange(firstLayerIndex, [VELViewCurrentAnimationLayersNeedingLayout count] - firstLayerIndex);
+        NSArray *layersNeedingLayout = [VELViewCurrentAnimationLayersNeedingLayout subarrayWithRange:layersRange];
 
-            case 0:
-                break;
+        // remove our layers before laying them out, in case layout starts
+        // another animation block
+        [VELViewCurrentAnimationLayersNeedingLayout removeObjectsInRange:layersRange];
 
-            default:
-                NSAssert(NO, @"Unrecognized animation curve in VELViewAnimationOptions %i", (int)options);
-        }
+        [layersNeedingLayout makeObjectsPerformSelector:@selector(layoutIfNeeded)];
     };
 
-    void (^animationsPlusLayout)(void) = ^{
-        animations();
+    [self animateWithSetupBlock:setup animations:animationsPlusLayout completion:completionBlock];
+}
 
-        NSSet *layersNeedingLayout = VELViewCurrentAnimationLayersNeedingLayout;
++ (void)animateWithDuration:(NSTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness animations:(void (^)(void))animations; {
+    [self animateWithDuration:duration damping:damping stiffness:stiffness animations:animations completion:^{}];
+}
 
-        // don't allow any new layers to get marked as needing layout
-        VELViewCurrentAnimationLayersNeedingLayout = nil;
++ (void)animateWithDuration:(NSTimeInterval)duration damping:(CGFloat)damping stiffness:(CGFloat)stiffness animations:(void (^)(void))animations completion:(void (^)(void))completionBlock; {
+    NSArray *progressValues = [VELKeyframeAction springProgressValuesWithDuration:duration damping:damping stiffness:stiffness];
+    [self animateWithDuration:duration keyTimes:nil progressValues:progressValues animations:animations completion:completionBlock];
+}
 
-        [layersNeedingLayout makeObjectsPerformSelector:@selector(layoutIfNeeded)];
++ (void)animateWithDuration:(NSTimeInterval)duration keyTimes:(NSArray *)keyTimes progressValues:(NSArray *)progressValues animations:(void (^)(void))animations completion:(void (^)(void))completionBlock; {
+    NSParameterAssert([progressValues count] >= 2);
+    NSParameterAssert(!keyTimes || [keyTimes count] == [progressValues count]);
+
+    void (^setup)(void) = ^{
+        VELViewCurrentAnimationOptions = 0;
+        VELViewCurrentAnimationLayoutGeneration = 0;
+        VELViewCurrentAnimationProgressValues = [progressValues copy];
+        VELViewCurrentAnimationKeyTimes = [keyTimes copy];
+
+        [CATransaction setAnimationDuration:duration];
     };
 
-    [self animateWithSetupBlock:setup animations:animationsPlusLayout completion:completionBlock];
+    [self animateWithSetupBlock:setup animations:animations completion:completionBlock];
 }
 
 - (void)changeLayerProperties:(void (^)(void))changesBlock; {
@@ -1334,27 +1699,115 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 
     changesBlock();
 
+    if (!VELViewCurrentAnimationLayoutGeneration)
+        return;
+
     VELViewAnimationOptions options = VELViewCurrentAnimationOptions;
 
-    if (options & VELViewAnimationOptionLayoutSubviews) {
-        if (VELViewCurrentAnimationLayersNeedingLayout && ![VELViewCurrentAnimationLayersNeedingLayout containsObject:self.layer]) {
-            [self.layer setNeedsLayout];
-            [VELViewCurrentAnimationLayersNeedingLayout addObject:self.layer];
+    if (options & VELViewAnimationOptionLayoutSubviews)
+        [[self class] setNeedsLayoutForAnimationOfLayer:self.layer owner:self];
+
+    if (options & VELViewAnimationOptionLayoutSuperview) {
+        CALayer *superlayer = self.layer.superlayer;
+
+        if (superlayer) {
+            VELView *superview = self.superview;
+            [[self class] setNeedsLayoutForAnimationOfLayer:superlayer owner:(superview.layer == superlayer ? superview : nil)];
         }
     }
+}
 
-    if ((options & VELViewAnimationOptionLayoutSuperview) && self.layer.superlayer) {
-        if (VELViewCurrentAnimationLayersNeedingLayout && ![VELViewCurrentAnimationLayersNeedingLayout containsObject:self.layer.superlayer]) {
-            [self.layer.superlayer setNeedsLayout];
-            [VELViewCurrentAnimationLayersNeedingLayout addObject:self.layer.superlayer];
-        }
++ (void)setNeedsLayoutForAnimationOfLayer:(CALayer *)layer owner:(VELView *)owner; {
+    NSUInteger generation = VELViewCurrentAnimationLayoutGeneration;
+
+    if (owner) {
+        if (owner->m_layoutGeneration == generation)
+            return;
+
+        owner->m_layoutGeneration = generation;
+    } else {
+        // this is rare enough (e.g., the superlayer of a view inside
+        // a VELScrollView) that an associated object is fine
+        NSNumber *layerGeneration = objc_getAssociatedObject(layer, &VELViewLayoutGenerationKey);
+        if ([layerGeneration unsignedIntegerValue] == generation)
+            return;
+
+        objc_setAssociatedObject(layer, &VELViewLayoutGenerationKey, [NSNumber numberWithUnsignedInteger:generation], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
     }
+
+    [layer setNeedsLayout];
+    [VELViewCurrentAnimationLayersNeedingLayout addObject:layer];
 }
 
 + (BOOL)isDefiningAnimation; {
     return VELViewCurrentAnimationBlockDepth > 0;
 }
 
+- (void)prepareForAnimationWithCompletion:(void (^)(void))completionBlock; {
+    NSMutableArray *hostingViews = [NSMutableArray array];
+
+    [self recursivelyEnumerateViewsUsingBlock:^(VELView *view){
+        if ([view isKindOfClass:[VELNSView class]])
+            [hostingViews addObject:view];
+    }];
+
+    [[VELAnimationManager defaultManager] prepareSnapshotsOfViews:hostingViews completion:completionBlock];
+}
+
+- (void)animateValueForKey:(NSString *)key toValue:(double)value duration:(NSTimeInterval)duration options:(VELViewAnimationOptions)options completion:(void (^)(BOOL finished))completionBlock; {
+    NSParameterAssert(key != nil);
+
+    double fromValue = [[self valueForKey:key] doubleValue];
+
+    VELCustomPropertyAnimation *animation = [[VELCustomPropertyAnimation alloc]
+        initWithObject:self
+        key:key
+        fromValue:fromValue
+        toValue:value
+        duration:duration
+        timingFunction:VELViewTimingFunctionForAnimationOptions(options)
+        completion:completionBlock
+    ];
+
+    [[VELAnimationManager defaultManager] addCustomPropertyAnimation:animation];
+}
+
+- (void)stopAnimatingValueForKey:(NSString *)key; {
+    [[VELAnimationManager defaultManager] stopCustomPropertyAnimationsOfObject:self forKey:key];
+}
+
++ (BOOL)mergesAnimationTransactions; {
+    return VELViewMergesAnimationTransactions;
+}
+
++ (void)setMergesAnimationTransactions:(BOOL)merges; {
+    NSAssert([NSThread isMainThread], @"Animation behavior should only be changed on the main thread");
+
+    VELViewMergesAnimationTransactions = merges;
+}
+
++ (BOOL)recordsAnimationTelemetry; {
+    return [VELAnimationManager defaultManager].recordingTelemetry;
+}
+
++ (void)setRecordsAnimationTelemetry:(BOOL)records; {
+    NSAssert([NSThread isMainThread], @"Animation behavior should only be changed on the main thread");
+
+    [VELAnimationManager defaultManager].recordingTelemetry = records;
+}
+
++ (NSDictionary *)animationTelemetry; {
+    return [[VELAnimationManager defaultManager] telemetry];
+}
+
++ (NSData *)animationTelemetryJSONData; {
+    return [[VELAnimationManager defaultManager] telemetryJSONData];
+}
+
++ (void)resetAnimationTelemetry; {
+    [[VELAnimationManager defaultManager] resetTelemetry];
+}
+
 #pragma mark NSEditor
 
 - (void)discardEditing; {
@@ -1458,7 +1911,16 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
 }
 
 - (id<CAAction>)actionForLayer:(CALayer *)layer forKey:(NSString *)key {
-    if (![VELCAAction interceptsActionForKey:key])
+    if (VELViewCurrentAnimationRecordsTelemetry)
+        [[VELAnimationManager defaultManager] recordTelemetryForLayer:layer];
+
+    // VELCAAction only adds behavior for hosted NSViews, so skip the wrapper
+    // entirely if there are none in this subtree
+    BOOL interceptsAction = m_hostedNSViewCount > 0 && [VELCAAction interceptsActionForKey:key];
+    BOOL capturesAnimationState = VELViewMergesAnimationTransactions && [[self class] isDefiningAnimation];
+    BOOL usesProgressCurve = VELViewCurrentAnimationProgressValues && [[self class] isDefiningAnimation];
+
+    if (!interceptsAction && !capturesAnimationState && !usesProgressCurve)
         return nil;
 
     // If we're being called inside the [layer actionForKey:key] call below,
@@ -1470,6 +1932,22 @@ static const VELViewAnimationOptions VELViewAnimationOptionCurveMask =
     id<CAAction> innerAction = [layer actionForKey:key];
     self.recursingActionForLayer = NO;
 
+    if (usesProgressCurve && [(id)innerAction isKindOfClass:[CABasicAnimation class]]) {
+        // only replace actions for animatable properties, and animate them
+        // along the curve instead
+        innerAction = [[VELKeyframeAction alloc]
+            initWithFromValue:VELViewStartingValueForKey(layer, key)
+            progressValues:VELViewCurrentAnimationProgressValues
+            keyTimes:VELViewCurrentAnimationKeyTimes
+            duration:[CATransaction animationDuration]
+        ];
+    } else if (capturesAnimationState) {
+        innerAction = VELViewActionCapturingAnimationState(innerAction, layer, key);
+    }
+
+    if (!interceptsAction)
+        return innerAction;
+
     return [VELCAAction actionWithAction:innerAction];
 }
 
@@ -129,6 +129,9 @@
 
     [self.undoManager removeAllActionsWithTarget:self];
     [[NSNotificationCenter defaultCenter] removeObserver:self];
+
+    // anything caching unretained responders must not outlive us
+    [VELView responderChainDidChange];
 }
 
 #pragma mark Presentation
@@ -181,6 +184,11 @@
     return YES;
 }
 
+- (void)setNextResponder:(NSResponder *)responder {
+    [super setNextResponder:responder];
+    [VELView responderChainDidChange];
+}
+
 #pragma mark View hierarchy
 
 - (VELView *)ancestorVELViewOfBridgedView:(id<VELBridgedView>)bridgedView; {
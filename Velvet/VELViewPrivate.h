@@ -29,4 +29,33 @@
  * the results of any drawing are cached in its layer.
  */
 + (BOOL)doesCustomDrawing;
+
+/**
+ * A counter which is incremented whenever the `nextResponder` of any <VELView>
+ * or <VELViewController> changes.
+ *
+ * This can be used to invalidate anything cached about the responder chain.
+ */
++ (NSUInteger)responderChainGeneration;
+
+/**
+ * Increments <responderChainGeneration>.
+ */
++ (void)responderChainDidChange;
+
+/**
+ * A counter which is incremented whenever the <subviews> of any <VELView> are
+ * inserted, removed, or reordered.
+ *
+ * This can be used to invalidate anything cached about the position of views
+ * within the hierarchy.
+ */
++ (NSUInteger)hierarchyGeneration;
+
+/**
+ * Whether the `NSView`s of several <VELNSView>s that moved together are about
+ * to be re-sorted all at once, in which case they should not be repositioned
+ * individually.
+ */
++ (BOOL)isRepositioningHostedNSViewsInBulk;
 @end
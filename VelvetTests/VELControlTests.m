@@ -39,6 +39,40 @@
     }];
 }
 
+- (void)testActionRegisteredForMultipleEventsIsInvokedOnce {
+    VELControl *control = [[VELControl alloc] init];
+
+    __block NSUInteger invocationCount = 0;
+    [control addActionForControlEvents:VELControlEventMouseUp usingBlock:^(NSEvent *event){
+        ++invocationCount;
+    }];
+
+    [control sendActionsForControlEvents:VELControlEventMouseUp];
+    STAssertEquals(invocationCount, (NSUInteger)1, @"");
+
+    [control sendActionsForControlEvents:VELControlEventMouseUpOutside];
+    STAssertEquals(invocationCount, (NSUInteger)2, @"");
+
+    [control sendActionsForControlEvents:VELControlEventMouseDown];
+    STAssertEquals(invocationCount, (NSUInteger)2, @"");
+}
+
+- (void)testRemovingActionFromWithinAction {
+    VELControl *control = [[VELControl alloc] init];
+
+    __block NSUInteger invocationCount = 0;
+    __block id action = nil;
+    
+    action = [control addActionForControlEvents:VELControlEventMouseDown usingBlock:^(NSEvent *event){
+        ++invocationCount;
+        [control removeAction:action forControlEvents:VELControlAllEvents];
+    }];
+
+    [control sendActionsForControlEvents:VELControlEventMouseDown];
+    [control sendActionsForControlEvents:VELControlEventMouseDown];
+    STAssertEquals(invocationCount, (NSUInteger)1, @"");
+}
+
 - (void)verifyControl:(VELControl *)control invokesActionForEvent:(VELControlEventMask)event usingBlock:(void (^)(void))block {
     __block BOOL handlerInvoked = NO;
     
@@ -53,6 +53,30 @@ static const NSInteger trueMouseEventNumberMinimum = 1000;
 + (void)stopEventLoop;
 @end
 
+@interface HitTestCountingView : VELView
+/**
+ * The number of times that <descendantViewAtPoint:> was invoked.
+ */
+@property (nonatomic, assign) NSUInteger hitTestCount;
+@end
+
+@interface VELEventManager (MouseTrackingTestAdditions)
+- (void)handleMouseTrackingEvent:(NSEvent *)event;
+@end
+
+@interface ReplayTestView : VELView
+/**
+ * The types of the events received by this view, as `NSNumber` objects, in the
+ * order they were received.
+ */
+@property (nonatomic, strong, readonly) NSMutableArray *receivedEventTypes;
+
+/**
+ * If not `nil`, invoked from <mouseDown:> after recording the event.
+ */
+@property (nonatomic, copy) void (^mouseDownBlock)(NSEvent *event);
+@end
+
 // used so that events will always be received even though the test window is
 // not truly key and active
 @interface AlwaysKeyVELWindow : VELWindow
@@ -357,6 +381,181 @@ SpecBegin(VELEventHandling)
                 expect(thirdRecognizer.lastEvent).not.toBeNil();
             });
         });
+
+        describe(@"mouse tracking", ^{
+            __block HitTestCountingView *containerView;
+            __block VELView *subview;
+            __block void (^moveMouseToPointInView)(CGPoint);
+
+            before(^{
+                containerView = [[HitTestCountingView alloc] initWithFrame:CGRectMake(0, 0, 200, 200)];
+                [window.rootView addSubview:containerView];
+
+                subview = [[VELView alloc] initWithFrame:CGRectMake(150, 150, 50, 50)];
+                [containerView addSubview:subview];
+
+                moveMouseToPointInView = [^(CGPoint point){
+                    NSEvent *event = [NSEvent
+                        mouseEventWithType:NSMouseMoved
+                        location:[containerView convertToWindowPoint:point]
+                        modifierFlags:0
+                        timestamp:[[NSProcessInfo processInfo] systemUptime]
+                        windowNumber:window.windowNumber
+                        context:window.graphicsContext
+                        eventNumber:0
+                        clickCount:0
+                        pressure:0
+                    ];
+
+                    [[VELEventManager defaultManager] handleMouseTrackingEvent:event];
+                } copy];
+            });
+
+            after(^{
+                containerView = nil;
+                subview = nil;
+                moveMouseToPointInView = nil;
+            });
+
+            it(@"should skip hit tests while the mouse stays inside the last responder", ^{
+                moveMouseToPointInView(CGPointMake(10, 10));
+                NSUInteger hitTestCount = containerView.hitTestCount;
+                expect(hitTestCount).toBeGreaterThan(0);
+
+                for (CGFloat x = 11; x < 15; ++x) {
+                    moveMouseToPointInView(CGPointMake(x, 10));
+                }
+
+                expect(containerView.hitTestCount).toEqual(hitTestCount);
+
+                // moving over the subview should hit test again
+                moveMouseToPointInView(CGPointMake(175, 175));
+                expect(containerView.hitTestCount).toBeGreaterThan(hitTestCount);
+            });
+
+            it(@"should hit test again after the view hierarchy changes", ^{
+                moveMouseToPointInView(CGPointMake(10, 10));
+                NSUInteger hitTestCount = containerView.hitTestCount;
+
+                [containerView addSubview:[[VELView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)]];
+
+                moveMouseToPointInView(CGPointMake(11, 10));
+                expect(containerView.hitTestCount).toBeGreaterThan(hitTestCount);
+            });
+
+            it(@"should periodically hit test while the mouse stays inside the last responder", ^{
+                moveMouseToPointInView(CGPointMake(10, 10));
+                NSUInteger hitTestCount = containerView.hitTestCount;
+
+                for (CGFloat x = 11; x < 111; ++x) {
+                    moveMouseToPointInView(CGPointMake(x, 10));
+                }
+
+                expect(containerView.hitTestCount).toBeGreaterThan(hitTestCount);
+                expect(containerView.hitTestCount).toBeLessThan(hitTestCount + 100);
+            });
+        });
+
+        describe(@"replaying delayed events", ^{
+            __block ReplayTestView *view;
+            __block NSEvent *(^eventOfType)(NSEventType);
+
+            before(^{
+                view = [[ReplayTestView alloc] initWithFrame:window.rootView.bounds];
+                [window.rootView addSubview:view];
+
+                [window makeFirstResponder:window];
+
+                eventOfType = [^(NSEventType type){
+                    return [NSEvent
+                        mouseEventWithType:type
+                        location:CGPointMake(50, 50)
+                        modifierFlags:0
+                        timestamp:[[NSProcessInfo processInfo] systemUptime]
+                        windowNumber:window.windowNumber
+                        context:window.graphicsContext
+                        eventNumber:0
+                        clickCount:1
+                        pressure:1
+                    ];
+                } copy];
+            });
+
+            after(^{
+                view = nil;
+                eventOfType = nil;
+            });
+
+            it(@"should deliver events in order", ^{
+                NSArray *events = [NSArray arrayWithObjects:eventOfType(NSLeftMouseDown), eventOfType(NSLeftMouseDragged), eventOfType(NSLeftMouseUp), nil];
+                NSArray *targets = [NSArray arrayWithObjects:view, view, view, nil];
+
+                [[VELEventManager defaultManager] replayDelayedEvents:events targets:targets];
+
+                NSArray *expectedTypes = [NSArray arrayWithObjects:
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseDown],
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseDragged],
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseUp],
+                    nil
+                ];
+
+                expect(view.receivedEventTypes).toEqual(expectedTypes);
+            });
+
+            it(@"should deliver events replayed during dispatch after the events already queued", ^{
+                __weak ReplayTestView *weakView = view;
+
+                view.mouseDownBlock = ^(NSEvent *event){
+                    [[VELEventManager defaultManager] replayDelayedEvents:[NSArray arrayWithObject:eventOfType(NSLeftMouseUp)] targets:[NSArray arrayWithObject:weakView]];
+
+                    // the new event should not be delivered re-entrantly
+                    expect(weakView.receivedEventTypes.count).toEqual(1);
+                };
+
+                NSArray *events = [NSArray arrayWithObjects:eventOfType(NSLeftMouseDown), eventOfType(NSLeftMouseDragged), nil];
+                NSArray *targets = [NSArray arrayWithObjects:view, view, nil];
+
+                [[VELEventManager defaultManager] replayDelayedEvents:events targets:targets];
+
+                NSArray *expectedTypes = [NSArray arrayWithObjects:
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseDown],
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseDragged],
+                    [NSNumber numberWithUnsignedInteger:NSLeftMouseUp],
+                    nil
+                ];
+
+                expect(view.receivedEventTypes).toEqual(expectedTypes);
+            });
+
+            it(@"should make the target of a replayed mouse down the first responder", ^{
+                expect(window.firstResponder).not.toEqual(view);
+
+                [[VELEventManager defaultManager] replayDelayedEvents:[NSArray arrayWithObject:eventOfType(NSLeftMouseDown)] targets:[NSArray arrayWithObject:view]];
+
+                expect(window.firstResponder).toEqual(view);
+            });
+
+            it(@"should hand first responder events back to AppKit", ^{
+                NSEvent *keyEvent = [NSEvent
+                    keyEventWithType:NSKeyDown
+                    location:CGPointZero
+                    modifierFlags:NSCommandKeyMask
+                    timestamp:[[NSProcessInfo processInfo] systemUptime]
+                    windowNumber:window.windowNumber
+                    context:window.graphicsContext
+                    characters:@"a"
+                    charactersIgnoringModifiers:@"a"
+                    isARepeat:NO
+                    keyCode:0
+                ];
+
+                // the view is not the first responder, so AppKit should not
+                // deliver the key event to it
+                [[VELEventManager defaultManager] replayDelayedEvents:[NSArray arrayWithObject:keyEvent] targets:[NSArray arrayWithObject:view]];
+
+                expect(view.receivedEventTypes).toEqual([NSArray array]);
+            });
+        });
     });
 
 SpecEnd
@@ -423,6 +622,58 @@ SpecEnd
 
 @end
 
+@implementation HitTestCountingView
+@synthesize hitTestCount = m_hitTestCount;
+
+- (id<VELBridgedView>)descendantViewAtPoint:(CGPoint)point {
+    ++self.hitTestCount;
+    return [super descendantViewAtPoint:point];
+}
+
+@end
+
+@implementation ReplayTestView
+@synthesize receivedEventTypes = m_receivedEventTypes;
+@synthesize mouseDownBlock = m_mouseDownBlock;
+
+- (id)initWithFrame:(CGRect)frame {
+    self = [super initWithFrame:frame];
+    if (!self)
+        return nil;
+
+    m_receivedEventTypes = [NSMutableArray array];
+    return self;
+}
+
+- (BOOL)acceptsFirstResponder {
+    return YES;
+}
+
+- (void)recordEvent:(NSEvent *)event {
+    [self.receivedEventTypes addObject:[NSNumber numberWithUnsignedInteger:event.type]];
+}
+
+- (void)mouseDown:(NSEvent *)event {
+    [self recordEvent:event];
+
+    if (self.mouseDownBlock)
+        self.mouseDownBlock(event);
+}
+
+- (void)mouseDragged:(NSEvent *)event {
+    [self recordEvent:event];
+}
+
+- (void)mouseUp:(NSEvent *)event {
+    [self recordEvent:event];
+}
+
+- (void)keyDown:(NSEvent *)event {
+    [self recordEvent:event];
+}
+
+@end
+
 @implementation AlwaysKeyVELWindow
 - (BOOL)isKeyWindow {
     return YES;
@@ -43,6 +43,13 @@
 @property (nonatomic, strong, readonly) NSMutableArray *eventQueue;
 @end
 
+@interface TestKeyValueObserver : NSObject
+/**
+ * The number of change notifications received so far.
+ */
+@property (nonatomic, assign) NSUInteger changeCount;
+@end
+
 SpecBegin(VELEventRecognizer)
 
     __block NSView *view;
@@ -142,6 +149,50 @@ SpecBegin(VELEventRecognizer)
         expect(recognizers).toBeNil();
     });
 
+    it(@"should attach multiple recognizers to a view at once", ^{
+        NSView *anotherView = [[NSView alloc] initWithFrame:CGRectZero];
+        TestEventRecognizer *anotherRecognizer = [[TestEventRecognizer alloc] init];
+
+        NSArray *recognizers = [NSArray arrayWithObjects:recognizer, anotherRecognizer, nil];
+        [VELEventRecognizer attachEventRecognizers:recognizers toView:anotherView];
+
+        expect(recognizer.view).toEqual(anotherView);
+        expect(anotherRecognizer.view).toEqual(anotherView);
+
+        expect([VELEventRecognizer eventRecognizersForView:anotherView]).toEqual(recognizers);
+        expect([VELEventRecognizer eventRecognizersForView:view]).toEqual([NSArray array]);
+    });
+
+    it(@"should notify observers of view when attaching multiple recognizers", ^{
+        NSView *anotherView = [[NSView alloc] initWithFrame:CGRectZero];
+
+        TestEventRecognizer *existingRecognizer = [[TestEventRecognizer alloc] init];
+        existingRecognizer.view = anotherView;
+
+        // cache a snapshot, which should be discarded by the batch
+        expect([VELEventRecognizer eventRecognizersForView:anotherView]).toEqual([NSArray arrayWithObject:existingRecognizer]);
+
+        TestKeyValueObserver *observer = [[TestKeyValueObserver alloc] init];
+        [recognizer addObserver:observer forKeyPath:@"view" options:0 context:NULL];
+
+        [VELEventRecognizer attachEventRecognizers:[NSArray arrayWithObject:recognizer] toView:anotherView];
+        [recognizer removeObserver:observer forKeyPath:@"view"];
+
+        expect(observer.changeCount).toEqual(1);
+        expect([VELEventRecognizer eventRecognizersForView:anotherView]).toEqual(([NSArray arrayWithObjects:existingRecognizer, recognizer, nil]));
+        expect([VELEventRecognizer eventRecognizersForView:view]).toEqual([NSArray array]);
+    });
+
+    it(@"should not modify a previously returned array of recognizers", ^{
+        NSArray *recognizers = [VELEventRecognizer eventRecognizersForView:view];
+
+        TestEventRecognizer *anotherRecognizer = [[TestEventRecognizer alloc] init];
+        anotherRecognizer.view = view;
+
+        expect(recognizers).toEqual([NSArray arrayWithObject:recognizer]);
+        expect([VELEventRecognizer eventRecognizersForView:view]).toEqual([NSArray arrayWithObjects:recognizer, anotherRecognizer, nil]);
+    });
+
     it(@"should not set recognizersRequiredToFail to nil", ^{
         recognizer.recognizersRequiredToFail = nil;
         expect(recognizer.recognizersRequiredToFail).toEqual([NSSet set]);
@@ -458,6 +509,64 @@ SpecBegin(VELEventRecognizer)
                 expect(cancelled).toBeFalsy();
             });
 
+            it(@"should coalesce changes when coalescesChangedActions is enabled", ^{
+                __block NSUInteger changeCount = 0;
+
+                [recognizer addActionUsingBlock:^(VELEventRecognizer *recognizer){
+                    if (recognizer.state == VELEventRecognizerStateChanged)
+                        ++changeCount;
+                }];
+
+                recognizer.coalescesChangedActions = YES;
+
+                [recognizer handleEvent:event];
+                expect(began).toBeTruthy();
+
+                for (unsigned i = 0; i < 3; ++i) {
+                    [recognizer handleEvent:event];
+                }
+
+                expect(changeCount).toEqual(0);
+                expect(changeCount).isGoing.toEqual(1);
+
+                [recognizer handleEvent:event];
+                [recognizer handleEvent:unrecognizedEvent];
+
+                // the pending change should be delivered before ending
+                expect(changeCount).toEqual(2);
+                expect(ended).toBeTruthy();
+            });
+
+            it(@"should coalesce changes across the main queue within one run loop iteration", ^{
+                __block NSUInteger changeCount = 0;
+
+                [recognizer addActionUsingBlock:^(VELEventRecognizer *recognizer){
+                    if (recognizer.state == VELEventRecognizerStateChanged)
+                        ++changeCount;
+                }];
+
+                recognizer.coalescesChangedActions = YES;
+
+                [recognizer handleEvent:event];
+                expect(began).toBeTruthy();
+
+                [recognizer handleEvent:event];
+                [recognizer handleEvent:event];
+
+                // the main queue is drained before the run loop waits again, so
+                // this change should still be coalesced with the others
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [recognizer handleEvent:event];
+                });
+
+                NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:0.1];
+                while ([timeoutDate timeIntervalSinceNow] > 0) {
+                    [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:timeoutDate];
+                }
+
+                expect(changeCount).toEqual(1);
+            });
+
             it(@"should fail to recognize an invalid continuous event", ^{
                 expect(recognizer.didReset).toBeFalsy();
 
@@ -643,6 +752,28 @@ SpecBegin(VELEventRecognizer)
             expect(recognizer.state).toEqual(VELEventRecognizerStateRecognized);
         });
 
+        it(@"should count each dependency failure only once", ^{
+            [recognizer handleEvent:event];
+            expect(recognizer.state).toEqual(VELEventRecognizerStatePossible);
+
+            [firstDependency handleEvent:unrecognizedEvent];
+            expect(firstDependency.state).toEqual(VELEventRecognizerStateFailed);
+
+            [firstDependency reset];
+            expect(recognizer.state).toEqual(VELEventRecognizerStatePossible);
+
+            [secondDependency handleEvent:unrecognizedEvent];
+            expect(recognizer.state).toEqual(VELEventRecognizerStateRecognized);
+        });
+
+        it(@"should not allow a dependency cycle", ^{
+            expect(^{
+                firstDependency.recognizersRequiredToFail = [NSSet setWithObject:recognizer];
+            }).toRaise(NSInternalInconsistencyException);
+
+            expect(firstDependency.recognizersRequiredToFail).toEqual([NSSet set]);
+        });
+
         it(@"should not handle events after dependencies, even if they later fail", ^{
             [recognizer handleEvent:event];
             expect(recognizer.state).toEqual(VELEventRecognizerStatePossible);
@@ -870,3 +1001,12 @@ SpecEnd
 }
 
 @end
+
+@implementation TestKeyValueObserver
+@synthesize changeCount = m_changeCount;
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary *)change context:(void *)context {
+    ++self.changeCount;
+}
+
+@end
@@ -9,6 +9,7 @@
 #import "VELNSViewTests.h"
 #import <Cocoa/Cocoa.h>
 #import <Velvet/Velvet.h>
+#import "VELNSViewPrivate.h"
 
 @interface VELNSViewTests ()
 @property (nonatomic, strong) VELWindow *window;
@@ -205,4 +206,196 @@
     STAssertEquals(hostView.guestView, scrollView, @"");
 }
 
+- (void)testNSViewOrderingMatchesVelvetHierarchy {
+    VELWindow *window = self.window;
+
+    VELView *backContainer = [[VELView alloc] init];
+    VELView *frontContainer = [[VELView alloc] init];
+    [window.rootView addSubview:backContainer];
+    [window.rootView addSubview:frontContainer];
+
+    NSView *frontHosted = [[NSView alloc] initWithFrame:CGRectZero];
+    [frontContainer addSubview:[[VELNSView alloc] initWithNSView:frontHosted]];
+
+    NSView *backHosted = [[NSView alloc] initWithFrame:CGRectZero];
+    [backContainer addSubview:[[VELNSView alloc] initWithNSView:backHosted]];
+
+    NSArray *subviews = frontHosted.superview.subviews;
+    STAssertTrue([subviews indexOfObjectIdenticalTo:backHosted] < [subviews indexOfObjectIdenticalTo:frontHosted], @"");
+
+    // move the back container to the front, and make sure the NSViews follow
+    [backContainer removeFromSuperview];
+    [window.rootView addSubview:backContainer];
+
+    subviews = frontHosted.superview.subviews;
+    STAssertTrue([subviews indexOfObjectIdenticalTo:frontHosted] < [subviews indexOfObjectIdenticalTo:backHosted], @"");
+}
+
+- (void)testNSViewOrderingAfterMovingSeveralHostedViewsTogether {
+    VELWindow *window = self.window;
+
+    VELView *group = [[VELView alloc] init];
+    VELView *frontContainer = [[VELView alloc] init];
+    VELView *newParent = [[VELView alloc] init];
+    [window.rootView addSubview:group];
+    [window.rootView addSubview:frontContainer];
+    [window.rootView addSubview:newParent];
+
+    NSMutableArray *groupHosted = [NSMutableArray array];
+    for (unsigned i = 0; i < 3; ++i) {
+        NSView *hosted = [[NSView alloc] initWithFrame:CGRectZero];
+        [group addSubview:[[VELNSView alloc] initWithNSView:hosted]];
+        [groupHosted addObject:hosted];
+    }
+
+    NSView *frontHosted = [[NSView alloc] initWithFrame:CGRectZero];
+    [frontContainer addSubview:[[VELNSView alloc] initWithNSView:frontHosted]];
+
+    // move the whole group in front of frontContainer, without leaving the
+    // NSVelvetView
+    [newParent addSubview:group];
+
+    NSArray *subviews = frontHosted.superview.subviews;
+    NSUInteger previousIndex = [subviews indexOfObjectIdenticalTo:frontHosted];
+
+    for (NSView *hosted in groupHosted) {
+        NSUInteger index = [subviews indexOfObjectIdenticalTo:hosted];
+        STAssertTrue(index > previousIndex, @"%@ should be in front of the previous hosted view in %@", hosted, subviews);
+
+        previousIndex = index;
+    }
+}
+
+- (void)testSnapshotIsReusedWhileContentIsUnchanged {
+    VELWindow *window = self.window;
+
+    NSView *hosted = [[NSView alloc] initWithFrame:CGRectZero];
+    VELNSView *view = [[VELNSView alloc] initWithNSView:hosted];
+    view.frame = CGRectMake(0, 0, 100, 100);
+    [window.rootView addSubview:view];
+
+    [view startRenderingContainedView];
+    id snapshot = view.layer.contents;
+    [view stopRenderingContainedView];
+
+    STAssertNotNil(snapshot, @"");
+
+    [view startRenderingContainedView];
+    STAssertEquals((__bridge void *)view.layer.contents, (__bridge void *)snapshot, @"");
+    [view stopRenderingContainedView];
+}
+
+- (void)testSnapshotIsInvalidatedByGuestSubtreeChanges {
+    VELWindow *window = self.window;
+
+    NSView *hosted = [[NSView alloc] initWithFrame:CGRectZero];
+    VELNSView *view = [[VELNSView alloc] initWithNSView:hosted];
+    view.frame = CGRectMake(0, 0, 100, 100);
+    [window.rootView addSubview:view];
+
+    NSView *subview = [[NSView alloc] initWithFrame:CGRectMake(10, 10, 20, 20)];
+    [hosted addSubview:subview];
+
+    __block id snapshot = nil;
+
+    BOOL (^snapshotChanged)(void) = ^{
+        [view startRenderingContainedView];
+        id newSnapshot = view.layer.contents;
+        [view stopRenderingContainedView];
+
+        BOOL changed = (newSnapshot != snapshot);
+        snapshot = newSnapshot;
+
+        return changed;
+    };
+
+    snapshotChanged();
+    STAssertFalse(snapshotChanged(), @"");
+
+    subview.frame = CGRectMake(20, 20, 20, 20);
+    STAssertTrue(snapshotChanged(), @"");
+
+    subview.frame = CGRectMake(20, 20, 30, 30);
+    STAssertTrue(snapshotChanged(), @"");
+
+    subview.hidden = YES;
+    STAssertTrue(snapshotChanged(), @"");
+
+    subview.hidden = NO;
+    subview.alphaValue = 0.5;
+    STAssertTrue(snapshotChanged(), @"");
+
+    [subview removeFromSuperview];
+    STAssertTrue(snapshotChanged(), @"");
+
+    [hosted addSubview:subview];
+    STAssertTrue(snapshotChanged(), @"");
+
+    [subview.layer setNeedsDisplay];
+    STAssertTrue(snapshotChanged(), @"");
+
+    // setting the same values again shouldn't throw away the snapshot
+    subview.frame = subview.frame;
+    subview.alphaValue = subview.alphaValue;
+    STAssertFalse(snapshotChanged(), @"");
+}
+
+- (void)testSnapshotIsInvalidatedByChangesToDescendantsOfAddedSubviews {
+    VELWindow *window = self.window;
+
+    NSView *hosted = [[NSView alloc] initWithFrame:CGRectZero];
+    VELNSView *view = [[VELNSView alloc] initWithNSView:hosted];
+    view.frame = CGRectMake(0, 0, 100, 100);
+    [window.rootView addSubview:view];
+
+    // build a hierarchy before adding it to the guest view
+    NSView *container = [[NSView alloc] initWithFrame:CGRectMake(0, 0, 50, 50)];
+    NSView *nestedView = [[NSView alloc] initWithFrame:CGRectMake(10, 10, 20, 20)];
+    [container addSubview:nestedView];
+    [hosted addSubview:container];
+
+    [view startRenderingContainedView];
+    id snapshot = view.layer.contents;
+    [view stopRenderingContainedView];
+
+    nestedView.hidden = YES;
+
+    [view startRenderingContainedView];
+    STAssertTrue((__bridge void *)view.layer.contents != (__bridge void *)snapshot, @"");
+    [view stopRenderingContainedView];
+}
+
+- (void)testSnapshotIsNotInvalidatedByViewsOutsideGuestHierarchy {
+    VELWindow *window = self.window;
+
+    NSView *hosted = [[NSView alloc] initWithFrame:CGRectZero];
+    VELNSView *view = [[VELNSView alloc] initWithNSView:hosted];
+    view.frame = CGRectMake(0, 0, 100, 100);
+    [window.rootView addSubview:view];
+
+    NSView *unrelatedView = [[NSView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)];
+    [unrelatedView setWantsLayer:YES];
+
+    NSView *unrelatedSubview = [[NSView alloc] initWithFrame:CGRectMake(0, 0, 10, 10)];
+
+    [view startRenderingContainedView];
+    id snapshot = view.layer.contents;
+    [view stopRenderingContainedView];
+
+    [unrelatedView addSubview:unrelatedSubview];
+    unrelatedView.frame = CGRectMake(10, 10, 30, 30);
+    unrelatedView.hidden = YES;
+    [unrelatedView setNeedsDisplay:YES];
+    [unrelatedView.layer setNeedsDisplay];
+
+    // changes off the main thread should be ignored
+    dispatch_sync(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [hosted.layer setNeedsDisplay];
+    });
+
+    [view startRenderingContainedView];
+    STAssertEquals((__bridge void *)view.layer.contents, (__bridge void *)snapshot, @"");
+    [view stopRenderingContainedView];
+}
+
 @end
@@ -13,6 +13,18 @@
 @interface DragDestinationView : VELView <VELDraggingDestination>
 @end
 
+@interface FileDragDestinationView : VELView <VELDraggingDestination>
+@end
+
+/*
+ * Stands in for the dragging info that AppKit would pass during a drag session,
+ * implementing only what the host view uses for lookup.
+ */
+@interface TestDraggingInfo : NSObject
+@property (nonatomic, strong) NSPasteboard *draggingPasteboard;
+@property (nonatomic, assign) NSPoint draggingLocation;
+@end
+
 @implementation VELViewDragAndDropTests
 
 - (void)testAutomaticRegistration {
@@ -28,10 +40,74 @@
     STAssertEquals([hostView.registeredDraggedTypes count], (NSUInteger)0, @"");
 }
 
+- (void)testDestinationLookupByPasteboardType {
+    NSVelvetView *hostView = [[NSVelvetView alloc] initWithFrame:CGRectMake(0, 0, 200, 100)];
+
+    DragDestinationView *stringDestination = [[DragDestinationView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
+    [hostView.guestView addSubview:stringDestination];
+
+    FileDragDestinationView *fileDestination = [[FileDragDestinationView alloc] initWithFrame:CGRectMake(100, 0, 100, 100)];
+    [hostView.guestView addSubview:fileDestination];
+
+    NSPasteboard *pasteboard = [NSPasteboard pasteboardWithUniqueName];
+    [pasteboard declareTypes:[NSArray arrayWithObject:NSPasteboardTypeString] owner:nil];
+    [pasteboard setString:@"foobar" forType:NSPasteboardTypeString];
+
+    TestDraggingInfo *draggingInfo = [[TestDraggingInfo alloc] init];
+    draggingInfo.draggingPasteboard = pasteboard;
+
+    // over the view registered for strings
+    draggingInfo.draggingLocation = NSMakePoint(50, 50);
+    STAssertEquals([hostView draggingEntered:(id)draggingInfo], NSDragOperationCopy, @"");
+    [hostView draggingExited:(id)draggingInfo];
+
+    // over a destination, but not one registered for any type on the pasteboard
+    draggingInfo.draggingLocation = NSMakePoint(150, 50);
+    STAssertEquals([hostView draggingEntered:(id)draggingInfo], NSDragOperationNone, @"");
+    [hostView draggingExited:(id)draggingInfo];
+
+    // the type index should be consulted again for each new session
+    [pasteboard declareTypes:[NSArray arrayWithObject:NSFilenamesPboardType] owner:nil];
+    [pasteboard setPropertyList:[NSArray arrayWithObject:@"/tmp"] forType:NSFilenamesPboardType];
+
+    STAssertEquals([hostView draggingEntered:(id)draggingInfo], NSDragOperationLink, @"");
+    [hostView draggingExited:(id)draggingInfo];
+
+    draggingInfo.draggingLocation = NSMakePoint(50, 50);
+    STAssertEquals([hostView draggingEntered:(id)draggingInfo], NSDragOperationNone, @"");
+    [hostView draggingExited:(id)draggingInfo];
+
+    // unregistered destinations should no longer be found
+    [fileDestination removeFromSuperview];
+
+    draggingInfo.draggingLocation = NSMakePoint(150, 50);
+    STAssertEquals([hostView draggingEntered:(id)draggingInfo], NSDragOperationNone, @"");
+    [hostView draggingEnded:(id)draggingInfo];
+}
+
 @end
 
 @implementation DragDestinationView
 - (NSArray *)supportedDragTypes; {
     return [NSArray arrayWithObjects:NSPasteboardTypeString, NSPasteboardTypeTIFF, nil];
 }
+
+- (NSDragOperation)draggingEntered:(id<NSDraggingInfo>)sender; {
+    return NSDragOperationCopy;
+}
+@end
+
+@implementation FileDragDestinationView
+- (NSArray *)supportedDragTypes; {
+    return [NSArray arrayWithObject:NSFilenamesPboardType];
+}
+
+- (NSDragOperation)draggingEntered:(id<NSDraggingInfo>)sender; {
+    return NSDragOperationLink;
+}
+@end
+
+@implementation TestDraggingInfo
+@synthesize draggingPasteboard = m_draggingPasteboard;
+@synthesize draggingLocation = m_draggingLocation;
 @end
@@ -8,6 +8,10 @@
 
 #import <Cocoa/Cocoa.h>
 #import <Velvet/Velvet.h>
+#import "VELAnimationManager.h"
+#import "VELCAAction.h"
+#import "VELKeyframeAction.h"
+#import "VELNSViewPrivate.h"
 
 @interface TestView : VELView
 @property (nonatomic, assign) BOOL willMoveToSuperviewInvoked;
@@ -21,6 +25,7 @@
 @property (nonatomic, unsafe_unretained) VELWindow *nextWindow;
 @property (nonatomic, assign) CGRect drawRectRegion;
 @property (nonatomic, assign) BOOL layoutSubviewsInvoked;
+@property (nonatomic, assign) double customValue;
 
 - (void)reset;
 @end
@@ -29,6 +34,11 @@
 - (void)editor:(id)editor didCommit:(BOOL)didCommit contextInfo:(void *)contextInfo;
 @end
 
+@interface VELCAAction (CompletionTestAdditions)
+- (VELCAAction *)completionBatch;
+- (void)runWhenAnimationCompletes:(void (^)(void))block forLayer:(CALayer *)layer;
+@end
+
 // Tests BS-1324
 @interface FrameSettingView : VELView
 @property (nonatomic, strong, readonly) VELView *subview;
@@ -97,6 +107,30 @@ describe(@"VELView", ^{
         expect([[view subviews] count]).toEqual(0);
     });
 
+    it(@"finds the ancestor shared with another view", ^{
+        VELView *root = [[VELView alloc] init];
+        VELView *branch = [[VELView alloc] init];
+        VELView *deepLeaf = [[VELView alloc] init];
+        VELView *shallowLeaf = [[VELView alloc] init];
+
+        [root addSubview:branch];
+        [root addSubview:shallowLeaf];
+        [branch addSubview:deepLeaf];
+
+        expect([deepLeaf ancestorSharedWithView:shallowLeaf]).toEqual(root);
+        expect([shallowLeaf ancestorSharedWithView:deepLeaf]).toEqual(root);
+        expect([deepLeaf ancestorSharedWithView:branch]).toEqual(branch);
+        expect([root ancestorSharedWithView:root]).toEqual(root);
+
+        // make sure cached depths are updated after moving views
+        [deepLeaf removeFromSuperview];
+        [shallowLeaf addSubview:deepLeaf];
+
+        expect([deepLeaf ancestorSharedWithView:shallowLeaf]).toEqual(shallowLeaf);
+        expect([deepLeaf ancestorSharedWithView:branch]).toEqual(root);
+        expect([deepLeaf ancestorSharedWithView:[[VELView alloc] init]]).toBeNil();
+    });
+
     it(@"sets subviews", ^{
         NSMutableArray *subviews = [[NSMutableArray alloc] init];
         for (NSUInteger i = 0;i < 4;++i) {
@@ -701,6 +735,30 @@ describe(@"VELView", ^{
             expect(testView.layoutSubviewsInvoked).toBeTruthy();
         });
 
+        it(@"should only lay out its own views in nested VELViewAnimationOptionLayoutSubviews blocks", ^{
+            TestView *outerView = [[TestView alloc] init];
+            TestView *innerView = [[TestView alloc] init];
+
+            [outerView reset];
+            [innerView reset];
+
+            [VELView animateWithDuration:0 options:VELViewAnimationOptionLayoutSubviews animations:^{
+                outerView.backgroundColor = [NSColor blueColor];
+
+                [VELView animateWithDuration:0 options:VELViewAnimationOptionLayoutSubviews animations:^{
+                    innerView.backgroundColor = [NSColor redColor];
+                }];
+
+                expect(innerView.layoutSubviewsInvoked).toBeTruthy();
+                expect(outerView.layoutSubviewsInvoked).toBeFalsy();
+
+                [innerView reset];
+            }];
+
+            expect(outerView.layoutSubviewsInvoked).toBeTruthy();
+            expect(innerView.layoutSubviewsInvoked).toBeFalsy();
+        });
+
         it(@"can animate VELViewAnimationOptionLayoutSuperview", ^{
             [testView addSubview:view];
             [testView reset];
@@ -763,6 +821,421 @@ describe(@"VELView", ^{
             });
         });
 
+        it(@"can prepare for animation", ^{
+            NSView *hosted = [[NSView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)];
+            VELNSView *hostView = [[VELNSView alloc] initWithNSView:hosted];
+
+            [testView addSubview:hostView];
+            [window.rootView addSubview:testView];
+
+            __block BOOL completed = NO;
+            [testView prepareForAnimationWithCompletion:^{
+                completed = YES;
+            }];
+
+            NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:1];
+            while (!completed && [timeoutDate timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:timeoutDate];
+            }
+
+            expect(completed).toBeTruthy();
+
+            VELAnimationManager *manager = [VELAnimationManager defaultManager];
+
+            [manager resetTelemetry];
+            manager.recordingTelemetry = YES;
+
+            // starting to animate should use the prepared snapshot, instead of
+            // rendering a new one
+            __block id snapshot = nil;
+
+            [VELView animate:^{
+                [hostView startRenderingContainedView];
+                snapshot = hostView.layer.contents;
+                [hostView stopRenderingContainedView];
+            }];
+
+            manager.recordingTelemetry = NO;
+
+            expect(snapshot).not.toBeNil();
+
+            NSDictionary *record = [[manager.telemetry objectForKey:@"animationBlocks"] lastObject];
+            expect([record objectForKey:@"snapshotCount"]).toEqual([NSNumber numberWithUnsignedInteger:0]);
+
+            [manager resetTelemetry];
+
+            [hostView startRenderingContainedView];
+            expect((__bridge void *)hostView.layer.contents == (__bridge void *)snapshot).toBeTruthy();
+            [hostView stopRenderingContainedView];
+        });
+
+        it(@"should complete animation preparations in the order they were requested", ^{
+            VELView *otherView = [[VELView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
+
+            [testView addSubview:[[VELNSView alloc] initWithNSView:[[NSView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)]]];
+            [otherView addSubview:[[VELNSView alloc] initWithNSView:[[NSView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)]]];
+
+            [window.rootView addSubview:testView];
+            [window.rootView addSubview:otherView];
+
+            NSMutableArray *completedViews = [NSMutableArray array];
+
+            [testView prepareForAnimationWithCompletion:^{
+                [completedViews addObject:testView];
+            }];
+
+            [otherView prepareForAnimationWithCompletion:^{
+                [completedViews addObject:otherView];
+            }];
+
+            NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:1];
+            while (completedViews.count < 2 && [timeoutDate timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:timeoutDate];
+            }
+
+            expect(completedViews.count).toEqual(2);
+            expect([completedViews objectAtIndex:0] == testView).toBeTruthy();
+            expect([completedViews objectAtIndex:1] == otherView).toBeTruthy();
+        });
+
+        it(@"can animate along a spring", ^{
+            [VELView animateWithDuration:0.5 damping:10 stiffness:100 animations:^{
+                testView.layer.position = CGPointMake(100, 100);
+            }];
+
+            CAKeyframeAnimation *animation = (id)[testView.layer animationForKey:@"position"];
+            expect(animation).toBeKindOf([CAKeyframeAnimation class]);
+            expect(animation.values.count).toEqual(31);
+            expect([animation.values lastObject]).toEqual([NSValue valueWithPoint:CGPointMake(100, 100)]);
+        });
+
+        it(@"can animate a rotation along a spring", ^{
+            CATransform3D rotation = CATransform3DMakeRotation(M_PI_2, 0, 0, 1);
+
+            [VELView animateWithDuration:0.5 damping:10 stiffness:100 animations:^{
+                testView.layer.transform = rotation;
+            }];
+
+            CAKeyframeAnimation *animation = (id)[testView.layer animationForKey:@"transform"];
+            expect(animation).toBeKindOf([CAKeyframeAnimation class]);
+            expect([animation.values objectAtIndex:0]).toEqual([NSValue valueWithCATransform3D:CATransform3DIdentity]);
+            expect([animation.values lastObject]).toEqual([NSValue valueWithCATransform3D:rotation]);
+
+            // element-wise interpolation would collapse the rotation, so every
+            // keyframe should keep its scale, and the spring should overshoot
+            CGFloat maximumAngle = 0;
+
+            for (NSValue *value in animation.values) {
+                CATransform3D transform = value.CATransform3DValue;
+
+                CGFloat scale = sqrt(transform.m11 * transform.m11 + transform.m12 * transform.m12);
+                expect(fabs(scale - 1) < 0.0001).toBeTruthy();
+
+                maximumAngle = fmax(maximumAngle, atan2(transform.m12, transform.m11));
+            }
+
+            expect(maximumAngle).toBeGreaterThan(M_PI_2);
+        });
+
+        it(@"can animate a custom property", ^{
+            testView.customValue = 1;
+
+            __block BOOL completed = NO;
+            [testView animateValueForKey:@"customValue" toValue:0.5 duration:0.1 options:VELViewAnimationOptionCurveEaseOut completion:^(BOOL didFinish){
+                completed = YES;
+            }];
+
+            NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:1];
+            while (!completed && [timeoutDate timeIntervalSinceNow] > 0) {
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:timeoutDate];
+            }
+
+            expect(completed).toBeTruthy();
+            expect(testView.customValue).toEqual(0.5);
+        });
+
+        it(@"should only reset the animation context duration in run loop iterations that changed it", ^{
+            VELAnimationManager *manager = [VELAnimationManager defaultManager];
+
+            BOOL resetsDuration = manager.resetsAnimationContextDuration;
+            manager.resetsAnimationContextDuration = YES;
+
+            void (^runLoopIteration)(void) = ^{
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+            };
+
+            // flush out any reset left over from earlier animations
+            runLoopIteration();
+            NSUInteger count = manager.touchedRunLoopIterationCount;
+
+            runLoopIteration();
+            expect(manager.touchedRunLoopIterationCount).toEqual(count);
+
+            // several changes in the same iteration should only be reset once
+            [VELView animateWithDuration:0.25 animations:^{
+                testView.alpha = 0.5;
+            }];
+
+            [VELView animateWithDuration:0.5 animations:^{
+                testView.alpha = 1;
+            }];
+
+            runLoopIteration();
+            expect(manager.touchedRunLoopIterationCount).toEqual(count + 1);
+
+            runLoopIteration();
+            expect(manager.touchedRunLoopIterationCount).toEqual(count + 1);
+
+            manager.resetsAnimationContextDuration = resetsDuration;
+        });
+
+        it(@"should record telemetry for animation blocks", ^{
+            [VELView resetAnimationTelemetry];
+            [VELView setRecordsAnimationTelemetry:YES];
+            expect([VELView recordsAnimationTelemetry]).toBeTruthy();
+
+            VELView *otherView = [[VELView alloc] init];
+
+            [VELView animateWithDuration:0.25 animations:^{
+                [testView actionForLayer:testView.layer forKey:@"position"];
+                [otherView actionForLayer:otherView.layer forKey:@"position"];
+
+                [VELView animateWithDuration:0.25 animations:^{
+                    [testView actionForLayer:testView.layer forKey:@"position"];
+                    [testView actionForLayer:testView.layer forKey:@"bounds"];
+                }];
+            }];
+
+            [VELView setRecordsAnimationTelemetry:NO];
+
+            // not recorded
+            [VELView animateWithDuration:0.25 animations:^{
+                [testView actionForLayer:testView.layer forKey:@"position"];
+            }];
+
+            NSDictionary *telemetry = [VELView animationTelemetry];
+            NSArray *animationBlocks = [telemetry objectForKey:@"animationBlocks"];
+            expect(animationBlocks.count).toEqual(2);
+
+            // blocks are listed in the order that they finished
+            NSDictionary *innerBlock = [animationBlocks objectAtIndex:0];
+            expect([innerBlock objectForKey:@"nestingLevel"]).toEqual([NSNumber numberWithUnsignedInteger:1]);
+            expect([innerBlock objectForKey:@"layerCount"]).toEqual([NSNumber numberWithUnsignedInteger:1]);
+            expect([innerBlock objectForKey:@"defineDuration"]).toBeKindOf([NSNumber class]);
+
+            NSDictionary *outerBlock = [animationBlocks objectAtIndex:1];
+            expect([outerBlock objectForKey:@"nestingLevel"]).toEqual([NSNumber numberWithUnsignedInteger:0]);
+            expect([outerBlock objectForKey:@"layerCount"]).toEqual([NSNumber numberWithUnsignedInteger:2]);
+
+            NSDictionary *JSONObject = [NSJSONSerialization JSONObjectWithData:[VELView animationTelemetryJSONData] options:0 error:NULL];
+            expect(JSONObject).toBeKindOf([NSDictionary class]);
+            expect([[JSONObject objectForKey:@"animationBlocks"] count]).toEqual(2);
+            expect([JSONObject objectForKey:@"frameIntervals"]).toBeKindOf([NSArray class]);
+
+            [VELView resetAnimationTelemetry];
+            expect([[[VELView animationTelemetry] objectForKey:@"animationBlocks"] count]).toEqual(0);
+        });
+
+        it(@"should not wrap actions for views without hosted NSViews", ^{
+            __block id<CAAction> action = nil;
+
+            [VELView animate:^{
+                action = [testView actionForLayer:testView.layer forKey:@"position"];
+            }];
+
+            expect(action == nil || ![(id)action isKindOfClass:[VELCAAction class]]).toBeTruthy();
+
+            [testView addSubview:[[VELNSView alloc] initWithNSView:[[NSView alloc] initWithFrame:NSZeroRect]]];
+
+            [VELView animate:^{
+                action = [testView actionForLayer:testView.layer forKey:@"position"];
+            }];
+
+            expect(action).toBeKindOf([VELCAAction class]);
+        });
+
+        describe(@"completion batches", ^{
+            __block CALayer *layer;
+            __block CALayer *otherLayer;
+
+            void (^runLoopUntil)(BOOL (^)(void)) = ^(BOOL (^condition)(void)){
+                NSDate *timeoutDate = [NSDate dateWithTimeIntervalSinceNow:1];
+                while (!condition() && [timeoutDate timeIntervalSinceNow] > 0) {
+                    [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:timeoutDate];
+                }
+            };
+
+            VELCAAction *(^runAnimation)(CALayer *, CFTimeInterval) = ^(CALayer *animatedLayer, CFTimeInterval duration){
+                CABasicAnimation *animation = [CABasicAnimation animationWithKeyPath:@"zPosition"];
+                animation.duration = duration;
+
+                VELCAAction *action = [VELCAAction actionWithAction:animation];
+                [action runActionForKey:@"zPosition" object:animatedLayer arguments:nil];
+
+                return action;
+            };
+
+            before(^{
+                layer = [CALayer layer];
+                otherLayer = [CALayer layer];
+
+                [window.rootView.layer addSublayer:layer];
+                [window.rootView.layer addSublayer:otherLayer];
+            });
+
+            after(^{
+                [layer removeFromSuperlayer];
+                [otherLayer removeFromSuperlayer];
+            });
+
+            it(@"should run blocks once, after the longest animation in the transaction", ^{
+                __block NSUInteger shortCount = 0;
+                __block NSUInteger longCount = 0;
+                __block CFTimeInterval shortCompletionTime = 0;
+
+                CFTimeInterval startTime = CACurrentMediaTime();
+
+                [CATransaction begin];
+
+                VELCAAction *shortAction = runAnimation(layer, 0.05);
+                VELCAAction *longAction = runAnimation(otherLayer, 0.25);
+
+                expect(shortAction.completionBatch).not.toBeNil();
+                expect(shortAction.completionBatch == longAction.completionBatch).toBeTruthy();
+
+                [shortAction runWhenAnimationCompletes:^{
+                    ++shortCount;
+                    shortCompletionTime = CACurrentMediaTime();
+                } forLayer:layer];
+
+                [longAction runWhenAnimationCompletes:^{
+                    ++longCount;
+                } forLayer:otherLayer];
+
+                [CATransaction commit];
+
+                runLoopUntil(^{ return (BOOL)(shortCount && longCount); });
+
+                expect(shortCount).toEqual(1);
+                expect(longCount).toEqual(1);
+                expect(shortCompletionTime - startTime).toBeGreaterThan(0.2);
+
+                // the blocks should not be run again
+                [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+
+                expect(shortCount).toEqual(1);
+                expect(longCount).toEqual(1);
+            });
+
+            it(@"should count an animation replaced on the same key as stopped", ^{
+                __block BOOL completed = NO;
+
+                [CATransaction begin];
+
+                // this would never finish in time, but is replaced below
+                VELCAAction *replacedAction = runAnimation(layer, 60);
+                VELCAAction *action = runAnimation(layer, 0.05);
+
+                [replacedAction runWhenAnimationCompletes:^{
+                    completed = YES;
+                } forLayer:layer];
+
+                [CATransaction commit];
+
+                runLoopUntil(^{ return completed; });
+                expect(completed).toBeTruthy();
+                expect(action.completionBatch == replacedAction.completionBatch).toBeTruthy();
+            });
+
+            it(@"should use separate batches for sibling animation blocks", ^{
+                __block VELCAAction *shortAction = nil;
+                __block VELCAAction *longAction = nil;
+
+                __block BOOL shortCompleted = NO;
+                __block BOOL longCompleted = NO;
+                __block BOOL longCompletedFirst = NO;
+
+                [VELView animateWithDuration:0.05 animations:^{
+                    shortAction = runAnimation(layer, 0.05);
+                    [shortAction runWhenAnimationCompletes:^{
+                        shortCompleted = YES;
+                        longCompletedFirst = longCompleted;
+                    } forLayer:layer];
+                }];
+
+                [VELView animateWithDuration:0.5 animations:^{
+                    longAction = runAnimation(otherLayer, 0.5);
+                    [longAction runWhenAnimationCompletes:^{
+                        longCompleted = YES;
+                    } forLayer:otherLayer];
+                }];
+
+                expect(shortAction.completionBatch).not.toBeNil();
+                expect(longAction.completionBatch).not.toBeNil();
+                expect(shortAction.completionBatch == longAction.completionBatch).toBeFalsy();
+
+                runLoopUntil(^{ return longCompleted; });
+
+                expect(shortCompleted).toBeTruthy();
+                expect(longCompleted).toBeTruthy();
+                expect(longCompletedFirst).toBeFalsy();
+            });
+
+            it(@"should track spring animations", ^{
+                __block VELCAAction *action = nil;
+                __block BOOL completed = NO;
+
+                [CATransaction begin];
+
+                NSArray *curve = [VELKeyframeAction springProgressValuesWithDuration:0.1 damping:10 stiffness:100];
+                VELKeyframeAction *keyframeAction = [[VELKeyframeAction alloc] initWithFromValue:[NSNumber numberWithDouble:0] progressValues:curve keyTimes:nil duration:0.1];
+
+                layer.zPosition = 1;
+
+                action = [VELCAAction actionWithAction:keyframeAction];
+                [action runActionForKey:@"zPosition" object:layer arguments:nil];
+
+                expect(action.completionBatch).not.toBeNil();
+                expect([layer animationForKey:@"zPosition"].delegate == action.completionBatch).toBeTruthy();
+
+                [action runWhenAnimationCompletes:^{
+                    completed = YES;
+                } forLayer:layer];
+
+                [CATransaction commit];
+
+                runLoopUntil(^{ return completed; });
+                expect(completed).toBeTruthy();
+            });
+        });
+
+        describe(@"merging animation transactions", ^{
+            before(^{
+                [VELView setMergesAnimationTransactions:YES];
+            });
+
+            after(^{
+                [VELView setMergesAnimationTransactions:NO];
+            });
+
+            it(@"should capture the starting state of each animation", ^{
+                __block CABasicAnimation *animation = nil;
+
+                [VELView animateWithDuration:0.25 options:VELViewAnimationOptionCurveLinear animations:^{
+                    animation = (id)[testView actionForLayer:testView.layer forKey:@"zPosition"];
+                }];
+
+                expect(animation).toBeKindOf([CABasicAnimation class]);
+                expect(animation.fromValue).toEqual([NSNumber numberWithDouble:testView.layer.zPosition]);
+                expect(animation.duration).toEqual(0.25);
+                expect(animation.timingFunction).toEqual([CAMediaTimingFunction functionWithName:kCAMediaTimingFunctionLinear]);
+            });
+
+            it(@"should not capture state outside of an animation", ^{
+                expect([testView actionForLayer:testView.layer forKey:@"zPosition"]).toBeNil();
+            });
+        });
+
         describe(@"inserts subviews at a specific index", ^{
             __block TestView *subview1;
             __block TestView *subview2;
@@ -876,6 +1349,7 @@ SpecEnd
 @synthesize nextWindow = m_nextWindow;
 @synthesize drawRectRegion = m_drawRectRegion;
 @synthesize layoutSubviewsInvoked = m_layoutSubviewsInvoked;
+@synthesize customValue = m_customValue;
 
 - (void)willMoveToSuperview:(VELView *)superview {
     [super willMoveToSuperview:superview];